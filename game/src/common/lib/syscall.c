@@ -15,13 +15,11 @@ void _exit(int status) {
 }
 
 int open(const char *pathname, int flags) {
-	nemu_assert(0);
-	return 0; 
+	return syscall(SYS_open, pathname, flags); 
 }
 
 int read(int fd, char *buf, int len) {
-	nemu_assert(0);
-	return 0; 
+	return syscall(SYS_read, fd, buf, len); 
 }
 
 int write(int fd, char *buf, int len) {
@@ -29,8 +27,7 @@ int write(int fd, char *buf, int len) {
 }
 
 off_t lseek(int fd, off_t offset, int whence) {
-	nemu_assert(0);
-	return 0; 
+	return syscall(SYS_lseek, fd, offset, whence); 
 }
 
 void *sbrk(int incr) {
@@ -48,9 +45,14 @@ void *sbrk(int incr) {
 	return prev_heap_end;
 }
 
+/* Only read-only mappings of files are supported. */
+void *mmap(void *addr, size_t len, int prot, int flags, int fd, off_t offset) {
+	uint32_t args[6] = { (uint32_t)addr, len, prot, flags, fd, offset };
+	return (void *)syscall(SYS_mmap, args);
+}
+
 int close(int fd) {
-	nemu_assert(0);
-	return 0; 
+	return syscall(SYS_close, fd); 
 }
 
 int fstat(int fd, struct stat *buf) {
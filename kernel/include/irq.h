@@ -3,14 +3,17 @@
 
 #include "common.h"
 
-/* TODO: The decleration order of the members in the ``TrapFrame''
- * structure below is wrong. Please re-orgainize it for the C
- * code to use the trap frame correctly.
+/* The trap frame built by ``asm_do_irq'' in do_irq.S: the registers
+ * saved by ``pushal'', the number and the error code pushed by the
+ * entry, and what the CPU pushes.
  */
-
 typedef struct TrapFrame {
-	uint32_t esi, ebx, eax, eip, edx, error_code, eflags, ecx, cs, old_esp, edi, ebp;
+	uint32_t edi, esi, ebp, old_esp, ebx, edx, ecx, eax;
 	int32_t irq;
+	uint32_t error_code, eip, cs, eflags;
 } TrapFrame;
 
+/* The number of interrupts and exceptions taken on each vector. */
+extern uint32_t irq_count[NR_IRQ];
+
 #endif
@@ -18,11 +18,34 @@
 /* NEMU has 128MB physical memory  */
 #define PHY_MEM   (128 * 1024 * 1024)
 
+/* the ramdisk window of NEMU, right above the physical memory */
+#define RAMDISK_BASE     PHY_MEM
+#define RAMDISK_MAX_SIZE (64 * 1024 * 1024)
+
 #define make_invalid_pde() 0
 #define make_invalid_pte() 0
 #define make_pde(addr) ((((uint32_t)(addr)) & 0xfffff000) | 0x7)
 #define make_pte(addr) ((((uint32_t)(addr)) & 0xfffff000) | 0x7)
+/* a PDE mapping a 4MB page, with CR4.PSE set */
+#define make_large_pde(addr) ((((uint32_t)(addr)) & 0xffc00000) | 0x87)
 
 uint32_t mm_malloc(uint32_t, int len);
 
+/* an area of the user address space, filled on page fault */
+typedef struct {
+	uint32_t start, end;
+	uint32_t disk_offset;
+	uint32_t file_size;
+	bool writable;
+} MmArea;
+
+MmArea *mm_add_area(uint32_t start, uint32_t end, uint32_t disk_offset, uint32_t file_size, bool writable);
+bool mm_fault(uint32_t);
+void mm_populate(uint32_t, uint32_t);
+PTE *get_upte(uint32_t);
+
+uint32_t user_run(uint32_t, uint32_t, bool, void **);
+int copy_from_user(void *, uint32_t, uint32_t);
+int copy_to_user(uint32_t, const void *, uint32_t);
+
 #endif
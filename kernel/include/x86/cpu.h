@@ -18,6 +18,28 @@ write_cr0(uint32_t cr0) {
 	asm volatile("movl %0, %%cr0" : : "r"(cr0));
 }
 
+/* read CR2, the linear address of the last page fault */
+static inline uint32_t
+read_cr2() {
+	uint32_t val;
+	asm volatile("movl %%cr2, %0" : "=r"(val));
+	return val;
+}
+
+/* read CR4 */
+static inline uint32_t
+read_cr4() {
+	uint32_t val;
+	asm volatile("movl %%cr4, %0" : "=r"(val));
+	return val;
+}
+
+/* write CR4 */
+static inline void
+write_cr4(uint32_t cr4) {
+	asm volatile("movl %0, %%cr4" : : "r"(cr4));
+}
+
 /* write CR3, notice that CR3 is never read */
 static inline void
 write_cr3(uint32_t cr3) {
@@ -27,6 +27,12 @@ out_long(uint16_t port, uint32_t data) {
 	asm volatile("out %%eax, %%dx" : : "a"(data), "d"(port));
 }
 
+/* write ``len'' bytes at ``buf'' to the port in one burst */
+static inline void
+out_bytes(uint16_t port, const void *buf, uint32_t len) {
+	asm volatile("cld; rep outsb" : "+S"(buf), "+c"(len) : "d"(port) : "memory");
+}
+
 static inline uint16_t
 in_word(uint16_t port) {
 	uint16_t data;
@@ -1,68 +1,184 @@
 #include "common.h"
-#define NR_SEC_BUF    128   /* sector buffer is a direct address hash */
+#include <string.h>
 
-void disk_do_read(void *, uint32_t);
-void disk_do_write(void *, uint32_t);
+/* The buffer cache keeps blocks of several sectors in a set associative
+ * cache with LRU replacement. A miss right after the previous block
+ * also reads the next blocks ahead, and whole blocks missing from the
+ * cache are read into the destination directly with one command.
+ */
 
-struct SectorBuf {
-	uint32_t sector;
+#define SEC_SIZE        512
+#define BLOCK_SHIFT     12
+#define BLOCK_SIZE      (1 << BLOCK_SHIFT)
+#define SEC_PER_BLOCK   (BLOCK_SIZE / SEC_SIZE)
+#define NR_SET          64
+#define NR_WAY          4
+#define NR_READ_AHEAD   4    /* blocks read ahead on a sequential miss */
+#define MAX_RUN         (256 / SEC_PER_BLOCK)   /* blocks in one command */
+
+void disk_do_read(void *, uint32_t, uint32_t);
+void disk_do_write(void *, uint32_t, uint32_t);
+
+struct BlockBuf {
+	uint32_t block;
+	uint32_t last_use;
 	bool used, dirty;
-	uint8_t content[512];
+	uint8_t content[BLOCK_SIZE];
 };
-static struct SectorBuf buf[NR_SEC_BUF];
+static struct BlockBuf buf[NR_SET][NR_WAY];
+
+static uint32_t use_cnt;
+static uint32_t next_block = -1;	/* the block after the last miss */
 
 void
 buf_init(void) {
-	int i;
-	for (i = 0; i < NR_SEC_BUF; i ++) {
-		buf[i].used = false;
+	int i, j;
+	for (i = 0; i < NR_SET; i ++) {
+		for (j = 0; j < NR_WAY; j ++) {
+			buf[i][j].used = false;
+			buf[i][j].dirty = false;
+		}
+	}
+}
+
+static void
+buf_flush(struct BlockBuf *ptr) {
+	if (ptr->used == true && ptr->dirty == true) {
+		disk_do_write(ptr->content, ptr->block * SEC_PER_BLOCK, SEC_PER_BLOCK);
+		ptr->dirty = false;
 	}
 }
 
 void
 buf_writeback(void) {
+	int i, j;
+	for (i = 0; i < NR_SET; i ++) {
+		for (j = 0; j < NR_WAY; j ++) {
+			buf_flush(&buf[i][j]);
+		}
+	}
+}
+
+static struct BlockBuf *
+buf_lookup(uint32_t block) {
+	struct BlockBuf *set = buf[block % NR_SET];
 	int i;
-	for (i = 0; i < NR_SEC_BUF; i ++) {
-		if (buf[i].dirty == true) {
-			disk_do_write(&buf[i].content, buf[i].sector);
-			buf[i].dirty = false;
+	for (i = 0; i < NR_WAY; i ++) {
+		if (set[i].used == true && set[i].block == block) {
+			set[i].last_use = ++ use_cnt;
+			return &set[i];
 		}
 	}
+	return NULL;
 }
 
-static struct SectorBuf *
-buf_fetch(uint32_t sector) {
-	struct SectorBuf *ptr = &buf[sector % NR_SEC_BUF];
-	
-	if (ptr->used == true && ptr->sector == sector) {
-		/* buf hit, do nothing */
-	} else {
-		if (ptr->used == true && ptr->dirty == true) {
-			/* write back */
-			disk_do_write(&ptr->content, ptr->sector);
+/* Take the least recently used buffer in the set of ``block'' for it,
+ * without reading the block.
+ */
+static struct BlockBuf *
+buf_alloc(uint32_t block) {
+	struct BlockBuf *set = buf[block % NR_SET];
+	struct BlockBuf *victim = &set[0];
+	int i;
+	for (i = 0; i < NR_WAY; i ++) {
+		if (set[i].used == false) {
+			victim = &set[i];
+			break;
 		}
-		/* issue a read command */
-		disk_do_read(&ptr->content, sector);
+		if (set[i].last_use < victim->last_use) {
+			victim = &set[i];
+		}
+	}
 
-		ptr->used = true;
-		ptr->sector = sector;
-		ptr->dirty = false;
+	buf_flush(victim);
+	victim->used = true;
+	victim->block = block;
+	victim->dirty = false;
+	victim->last_use = ++ use_cnt;
+	return victim;
+}
+
+static struct BlockBuf *
+buf_fetch(uint32_t block) {
+	struct BlockBuf *ptr = buf_lookup(block);
+	if (ptr != NULL) {
+		/* buf hit, do nothing */
+		return ptr;
+	}
+
+	int nr_block = (block == next_block ? 1 + NR_READ_AHEAD : 1);
+	int i;
+	for (i = 0; i < nr_block; i ++) {
+		if (i == 0 || buf_lookup(block + i) == NULL) {
+			struct BlockBuf *p = buf_alloc(block + i);
+			disk_do_read(p->content, (block + i) * SEC_PER_BLOCK, SEC_PER_BLOCK);
+			if (i == 0) { ptr = p; }
+		}
 	}
+	next_block = block + nr_block;
+
+	/* the read ahead blocks may have taken the LRU stamp */
+	ptr->last_use = ++ use_cnt;
 	return ptr;
 }
 
-uint8_t
-read_byte(uint32_t offset) {
-	uint32_t sector = offset >> 9;
-	struct SectorBuf *ptr = buf_fetch(sector);
-	return ptr->content[offset & 511];
+/* Count the blocks from ``block'' which are missing from the cache. */
+static uint32_t
+missing_run(uint32_t block, uint32_t max) {
+	uint32_t n = 0;
+	while (n < max && n < MAX_RUN && buf_lookup(block + n) == NULL) {
+		n ++;
+	}
+	return n;
 }
 
 void
-write_byte(uint32_t offset, uint8_t data) {
-	uint32_t sector = offset >> 9;
-	struct SectorBuf *ptr = buf_fetch(sector);
-	ptr->content[offset & 511] = data;
-	ptr->dirty = true;
+buf_read(uint8_t *dst, uint32_t offset, uint32_t len) {
+	while (len > 0) {
+		uint32_t block = offset >> BLOCK_SHIFT;
+		uint32_t in_block = offset & (BLOCK_SIZE - 1);
+		uint32_t n = BLOCK_SIZE - in_block;
+		uint32_t run;
+
+		if (in_block == 0 && (run = missing_run(block, len >> BLOCK_SHIFT)) > 0) {
+			/* stream whole blocks, bypassing the cache */
+			n = run << BLOCK_SHIFT;
+			disk_do_read(dst, block * SEC_PER_BLOCK, run * SEC_PER_BLOCK);
+			next_block = block + run;
+		}
+		else {
+			if (n > len) { n = len; }
+			memcpy(dst, buf_fetch(block)->content + in_block, n);
+		}
+
+		dst += n;
+		offset += n;
+		len -= n;
+	}
 }
 
+void
+buf_write(const uint8_t *src, uint32_t offset, uint32_t len) {
+	while (len > 0) {
+		uint32_t block = offset >> BLOCK_SHIFT;
+		uint32_t in_block = offset & (BLOCK_SIZE - 1);
+		uint32_t n = BLOCK_SIZE - in_block;
+		if (n > len) { n = len; }
+
+		struct BlockBuf *ptr;
+		if (n == BLOCK_SIZE) {
+			/* the whole block is overwritten, no need to read it */
+			ptr = buf_lookup(block);
+			if (ptr == NULL) { ptr = buf_alloc(block); }
+		}
+		else {
+			ptr = buf_fetch(block);
+		}
+		memcpy(ptr->content + in_block, src, n);
+		ptr->dirty = true;
+
+		src += n;
+		offset += n;
+		len -= n;
+	}
+}
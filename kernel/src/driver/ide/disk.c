@@ -15,8 +15,9 @@ static void waitdisk() {
 	while ( (in_byte(IDE_PORT_BASE + 7) & (0x80 | 0x40)) != 0x40);
 }
 
+/* ``nr_sector'' is at most 256, which is written as 0 */
 static void
-ide_prepare(uint32_t sector) {
+ide_prepare(uint32_t sector, uint32_t nr_sector) {
 	waitdisk();
 
 #ifdef USE_DMA_READ
@@ -25,7 +26,7 @@ ide_prepare(uint32_t sector) {
 	out_byte(IDE_PORT_BASE + 1, 0);
 #endif
 
-	out_byte(IDE_PORT_BASE + 2, 1);
+	out_byte(IDE_PORT_BASE + 2, nr_sector & 0xFF);
 	out_byte(IDE_PORT_BASE + 3, sector & 0xFF);
 	out_byte(IDE_PORT_BASE + 4, (sector >> 8) & 0xFF);
 	out_byte(IDE_PORT_BASE + 5, (sector >> 16) & 0xFF);
@@ -47,36 +48,38 @@ issue_write() {
 	out_byte(IDE_PORT_BASE + 7, 0x30);
 }
 
+/* Read ``nr_sector'' (at most 256) sectors with one command. */
 void
-disk_do_read(void *buf, uint32_t sector) {
+disk_do_read(void *buf, uint32_t sector, uint32_t nr_sector) {
 #ifdef USE_DMA_READ
-	dma_prepare(buf);
-
-	clear_ide_intr();
-#endif
-
-	ide_prepare(sector);
+	/* The PRDT has a single entry of one sector. */
+	for (; nr_sector > 0; nr_sector --, sector ++, buf += 512) {
+		dma_prepare(buf);
+
+		clear_ide_intr();
+		ide_prepare(sector, 1);
+		issue_read();
+		wait_ide_intr();
+	}
+#else
+	ide_prepare(sector, nr_sector);
 	issue_read();
 
-#ifdef USE_DMA_READ
-	wait_ide_intr();
-#else
-	int i;
-	for (i = 0; i < 512 / sizeof(uint32_t); i ++) {
-		*(((uint32_t*)buf) + i) = in_long(IDE_PORT_BASE);
+	uint32_t *p = buf, *end = p + nr_sector * (512 / sizeof(uint32_t));
+	waitdisk();
+	while (p < end) {
+		*p ++ = in_long(IDE_PORT_BASE);
 	}
 #endif
-
 }
 
 void
-disk_do_write(void *buf, uint32_t sector) {
-	int i;
-
-	ide_prepare(sector);
+disk_do_write(void *buf, uint32_t sector, uint32_t nr_sector) {
+	ide_prepare(sector, nr_sector);
 	issue_write();
 
-	for (i = 0; i < 512 / sizeof(uint32_t); i ++) {
-		out_long(IDE_PORT_BASE, *(((uint32_t*)buf) + i));
+	uint32_t *p = buf, *end = p + nr_sector * (512 / sizeof(uint32_t));
+	while (p < end) {
+		out_long(IDE_PORT_BASE, *p ++);
 	}
 }
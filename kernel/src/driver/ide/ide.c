@@ -5,27 +5,21 @@
 
 void buf_init(void);
 void buf_writeback(void);
-uint8_t read_byte(uint32_t);
-void write_byte(uint32_t, uint8_t);
+void buf_read(uint8_t *, uint32_t, uint32_t);
+void buf_write(const uint8_t *, uint32_t, uint32_t);
 
-void add_irq_handle(int, void (*)(void));
+int add_irq_handle(int, void (*)(void));
 
 /* The kernel is monolithic, therefore we do not need to
  * translate the address ``buf'' from the user process to
  * a physical one, which is necessary for a microkernel.
  */
 void ide_read(uint8_t *buf, uint32_t offset, uint32_t len) {
-	uint32_t i;
-	for (i = 0; i < len; i ++) {
-		buf[i] = read_byte(offset + i);
-	}
+	buf_read(buf, offset, len);
 }
 
 void ide_write(uint8_t *buf, uint32_t offset, uint32_t len) {
-	uint32_t i;
-	for (i = 0; i < len; i ++) {
-		write_byte(offset + i, buf[i]);
-	}
+	buf_write(buf, offset, len);
 }
 
 static void
@@ -1,7 +1,18 @@
 #include "common.h"
+#include "memory.h"
 #include <string.h>
 
-#define RAMDISK_START ((void *)0)
+/* NEMU maps the whole disk image into a window of physical memory, so
+ * the ramdisk can be of any size up to RAMDISK_MAX_SIZE.
+ */
+#define RAMDISK_START ((uint8_t *)pa_to_va(RAMDISK_BASE))
+
+/* Return the address of the data at ``offset'', which can be used in
+ * place instead of being copied.
+ */
+uint8_t *ramdisk_ptr(uint32_t offset) {
+	return RAMDISK_START + offset;
+}
 
 /* The kernel is monolithic, therefore we do not need to
  * translate the address ``buf'' from the user process to
@@ -14,4 +25,3 @@ void ramdisk_read(uint8_t *buf, uint32_t offset, uint32_t len) {
 void ramdisk_write(uint8_t *buf, uint32_t offset, uint32_t len) {
 	memcpy(RAMDISK_START + offset, buf, len);
 }
-
@@ -7,70 +7,87 @@
 
 #ifdef HAS_DEVICE
 void ide_read(uint8_t *, uint32_t, uint32_t);
+#define disk_read ide_read
 #else
 void ramdisk_read(uint8_t *, uint32_t, uint32_t);
+#define disk_read ramdisk_read
 #endif
 
 #define STACK_SIZE (1 << 20)
 
+/* program headers read from the disk at a time */
+#define NR_PH_BUF 16
+
 void create_video_mapping();
 uint32_t get_ucr3();
 
-uint32_t loader() {
-	Elf32_Ehdr *elf;
-	Elf32_Phdr *ph = NULL;
+static void load_segment(Elf32_Phdr *ph) {
+	if(ph->p_type != PT_LOAD) { return; }
 
-	uint8_t buf[4096];
+#ifdef IA32_PAGE
+	/* The segment is read on page fault, or now without IA32_INTR. */
+	mm_add_area(ph->p_vaddr, ph->p_vaddr + ph->p_memsz,
+			ELF_OFFSET_IN_DISK + ph->p_offset, ph->p_filesz, true);
+#ifndef IA32_INTR
+	mm_populate(ph->p_vaddr, ph->p_vaddr + ph->p_memsz);
+#endif
 
-#ifdef HAS_DEVICE
-	ide_read(buf, ELF_OFFSET_IN_DISK, 4096);
+	/* Record the program break for future use. */
+	extern uint32_t brk;
+	uint32_t new_brk = ph->p_vaddr + ph->p_memsz - 1;
+	if(brk < new_brk) { brk = new_brk; }
 #else
-	ramdisk_read(buf, ELF_OFFSET_IN_DISK, 4096);
+	/* Read [VirtAddr, VirtAddr + FileSiz) with one transfer right into
+	 * its place, and zero [VirtAddr + FileSiz, VirtAddr + MemSiz).
+	 */
+	disk_read((uint8_t *)ph->p_vaddr, ELF_OFFSET_IN_DISK + ph->p_offset, ph->p_filesz);
+	memset((void *)(ph->p_vaddr + ph->p_filesz), 0, ph->p_memsz - ph->p_filesz);
 #endif
+}
 
-	elf = (void*)buf;
-
-	/* DONE: fix the magic number with the correct one */
-	const uint32_t elf_magic = 0x464c457f;
-	uint32_t *p_magic = (void *)buf;
-	nemu_assert(*p_magic == elf_magic);
-
-	/* Load each program segment */
-	//panic("please implement me");
-	ph = (Elf32_Phdr *)(buf + elf->e_phoff);
-	uint16_t i = 0;
-	for(i = 0; i < elf->e_phnum; ++i) {
-		//if(elf->e_phnum == 3) {HIT_BAD_TRAP;}
-		/* Scan the program header table, load each segment into memory */
-		if(ph->p_type == PT_LOAD) {
-
-			/* DONE: read the content of the segment from the ELF file to the memory region [VirtAddr, VirtAddr + FileSiz) */
-			ramdisk_read((uint8_t *)(ph->p_vaddr), ph->p_offset, ph->p_filesz);
-
-			/* DONE: zero the memory region [VirtAddr + FileSiz, VirtAddr + MemSiz)	 */
-			memset((void *)(ph->p_vaddr+ph->p_filesz), 0, ph->p_memsz - ph->p_filesz);
-
+uint32_t loader() {
+	Elf32_Ehdr elf;
+	Elf32_Phdr ph[NR_PH_BUF];
 
 #ifdef IA32_PAGE
-			/* Record the program break for future use. */
-			extern uint32_t brk;
-			uint32_t new_brk = ph->p_vaddr + ph->p_memsz - 1;
-			if(brk < new_brk) { brk = new_brk; }
+	/* The segments are filled through the user address space. */
+	write_cr3(get_ucr3());
 #endif
+
+	disk_read((void *)&elf, ELF_OFFSET_IN_DISK, sizeof(elf));
+
+	/* DONE: fix the magic number with the correct one */
+	const uint32_t elf_magic = 0x464c457f;
+	nemu_assert(*(uint32_t *)elf.e_ident == elf_magic);
+	nemu_assert(elf.e_phentsize == sizeof(Elf32_Phdr));
+
+	/* Load each program segment. The program headers are read in
+	 * batches, so there can be any number of them.
+	 */
+	int i, j, n;
+	for(i = 0; i < elf.e_phnum; i += n) {
+		n = elf.e_phnum - i;
+		if(n > NR_PH_BUF) { n = NR_PH_BUF; }
+		disk_read((void *)ph, ELF_OFFSET_IN_DISK + elf.e_phoff + i * sizeof(Elf32_Phdr),
+				n * sizeof(Elf32_Phdr));
+		for(j = 0; j < n; j ++) {
+			load_segment(&ph[j]);
 		}
-		ph++;
 	}
 
-	volatile uint32_t entry = elf->e_entry;
+	volatile uint32_t entry = elf.e_entry;
 
 #ifdef IA32_PAGE
-	mm_malloc(KOFFSET - STACK_SIZE, STACK_SIZE);
+	/* The stack is mapped eagerly, since there is no stack switch
+	 * and a #PF on the stack could not be raised.
+	 */
+	mm_add_area(KOFFSET - STACK_SIZE, KOFFSET, 0, 0, true);
+	mm_populate(KOFFSET - STACK_SIZE, KOFFSET);
 
 #ifdef HAS_DEVICE
 	create_video_mapping();
-#endif
-
 	write_cr3(get_ucr3());
+#endif
 #endif
 
 	return entry;
@@ -33,7 +33,20 @@ static void set_trap(GateDesc *ptr, uint32_t selector, uint32_t offset, uint32_t
 
 void irq0();
 void irq1();
+void irq2();
+void irq3();
+void irq4();
+void irq5();
+void irq6();
+void irq7();
+void irq8();
+void irq9();
+void irq10();
+void irq11();
+void irq12();
+void irq13();
 void irq14();
+void irq15();
 void vec0();
 void vec1();
 void vec2();
@@ -77,8 +90,14 @@ void init_idt() {
 	/* the system call 0x80 */
 	set_trap(idt + 0x80, SEG_KERNEL_CODE << 3, (uint32_t)vecsys, DPL_USER);
 
-	set_intr(idt+32 + 0, SEG_KERNEL_CODE << 3, (uint32_t)irq0, DPL_KERNEL);
-	set_intr(idt+32 + 14, SEG_KERNEL_CODE << 3, (uint32_t)irq14, DPL_KERNEL);
+	/* the hardware interrupts from the i8259 */
+	static void (*irq[16])() = {
+		irq0, irq1, irq2, irq3, irq4, irq5, irq6, irq7,
+		irq8, irq9, irq10, irq11, irq12, irq13, irq14, irq15
+	};
+	for (i = 0; i < 16; i ++) {
+		set_intr(idt+32 + i, SEG_KERNEL_CODE << 3, (uint32_t)irq[i], DPL_KERNEL);
+	}
 
 	/* the ``idt'' is its virtual address */
 	write_idtr(idt, sizeof(idt));
@@ -1,57 +1,75 @@
 #include "irq.h"
 
-#define NR_IRQ_HANDLE 32
-
-/* There are no more than 16(actually, 3) kinds of hardward interrupts. */
+/* There are no more than 16 kinds of hardware interrupts. */
 #define NR_HARD_INTR 16
+#define NR_HANDLE_PER_IRQ 4
+
+#define IRQ_BASE 32
 
-struct IRQ_t {
-	void (*routine)(void);
-	struct IRQ_t *next;
-};
+/* Each hardware interrupt has its own array of handlers, so the
+ * dispatch does not walk a list shared by all of them. The i8259 is
+ * initialized with automatic EOI in init_i8259(), so the handlers never
+ * send EOI to it.
+ */
+static void (*handles[NR_HARD_INTR][NR_HANDLE_PER_IRQ])(void);
+static volatile int nr_handle[NR_HARD_INTR];
 
-static struct IRQ_t handle_pool[NR_IRQ_HANDLE];
-static struct IRQ_t *handles[NR_HARD_INTR];
-static int handle_count = 0;
+uint32_t irq_count[NR_IRQ];
 
 void do_syscall(TrapFrame *);
+bool mm_fault(uint32_t);
 
-void
+/* The handler is in place before it is counted, so an interrupt in the
+ * middle sees either the old handlers or the new ones, without cli().
+ * The IRQ comes from user programs too, so it is checked. Return 0, or
+ * -1 if the IRQ is invalid or has too many handlers.
+ */
+int
 add_irq_handle(int irq, void (*func)(void) ) {
-	assert(irq < NR_HARD_INTR);
-	assert(handle_count <= NR_IRQ_HANDLE);
-
-	struct IRQ_t *ptr;
-	ptr = &handle_pool[handle_count ++]; /* get a free handler */
-	ptr->routine = func;
-	ptr->next = handles[irq]; /* insert into the linked list */
-	handles[irq] = ptr;
+	if (irq < 0 || irq >= NR_HARD_INTR || nr_handle[irq] >= NR_HANDLE_PER_IRQ) {
+		return -1;
+	}
+
+	handles[irq][nr_handle[irq]] = func;
+	asm volatile ("" : : : "memory");
+	nr_handle[irq] ++;
+	return 0;
 }
 
 void irq_handle(TrapFrame *tf) {
-	/* TODO: Re-organize the ``TrapFrame'' structure in `include/irq.h'
-	 * to match the trap frame built during ``do_irq.S''. Remove the 
-	 * following line after you are done.
-	 */
-	panic("Have you re-organized the ``TrapFrame'' structure?");
-
 	int irq = tf->irq;
 
+	if (irq >= 1000) {
+		/* Hardware interrupts come first, for the timer is the most
+		 * frequent one. An interrupt without any handler, such as a
+		 * spurious IRQ 7, is only counted.
+		 */
+		int irq_id = irq - 1000;
+		irq_count[IRQ_BASE + irq_id] ++;
+
+		int i, n = nr_handle[irq_id];
+		for (i = 0; i < n; i ++) {
+			handles[irq_id][i]();
+		}
+		return;
+	}
+
 	if (irq < 0) {
 		panic("Unhandled exception!");
-	} else if (irq == 0x80) {
-		do_syscall(tf);
-	} else if (irq < 1000) {
-		panic("Unexpected exception #%d at eip = %x", irq, tf->eip);
-	} else if (irq >= 1000) {
-		int irq_id = irq - 1000;
-		assert(irq_id < NR_HARD_INTR);
-		struct IRQ_t *f = handles[irq_id];
+		return;
+	}
 
-		while (f != NULL) { /* call handlers one by one */
-			f->routine(); 
-			f = f->next;
+	irq_count[irq] ++;
+	if (irq == 0x80) {
+		do_syscall(tf);
+#ifdef IA32_PAGE
+	} else if (irq == 14) {
+		uint32_t addr = read_cr2();
+		if (!mm_fault(addr)) {
+			panic("Page fault at %x, eip = %x", addr, tf->eip);
 		}
+#endif
+	} else {
+		panic("Unexpected exception #%d at eip = %x", irq, tf->eip);
 	}
 }
-
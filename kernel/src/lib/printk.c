@@ -1,7 +1,7 @@
 #include "common.h"
 #include <stdio.h>
 
-void serial_printc(char);
+void serial_write(const char *, int);
 
 /* __attribute__((__noinline__))  here is to disable inlining for this function to avoid some optimization problems for gcc 4.7 */
 void __attribute__((__noinline__)) 
@@ -12,8 +12,5 @@ printk(const char *ctl, ...) {
 	static char buf[256];
 	void *args = (void **)&ctl + 1;
 	int len = vsnprintf(buf, 256, ctl, args);
-	int i;
-	for(i = 0; i < len; i ++) {
-		serial_printc(buf[i]);
-	}
+	serial_write(buf, len);
 }
@@ -1,7 +1,15 @@
 #include "common.h"
 #include "x86.h"
+#include "memory.h"
 
 #define SERIAL_PORT  0x3F8
+#define FIFO_SIZE    16
+
+/* the fast console of NEMU, see nemu/src/device/serial.c */
+#define CONSOLE_PORT  0x3E0
+#define CONSOLE_MAGIC 0x554d454e
+
+static bool fast_console;
 
 void
 init_serial(void) {
@@ -12,6 +20,8 @@ init_serial(void) {
 	out_byte(SERIAL_PORT + 3, 0x03);
 	out_byte(SERIAL_PORT + 2, 0xC7);
 	out_byte(SERIAL_PORT + 4, 0x0B);
+
+	fast_console = (in_long(CONSOLE_PORT) == CONSOLE_MAGIC);
 }
 
 static inline int
@@ -24,3 +34,28 @@ serial_printc(char ch) {
 	while (!serial_idle());
 	out_byte(SERIAL_PORT, ch);
 }
+
+/* Send a buffer of the kernel. With the fast console, the whole buffer
+ * goes with one ``out''. Otherwise the transmit FIFO is filled in one
+ * burst each time it is empty.
+ */
+void
+serial_write(const char *buf, int len) {
+	if (fast_console) {
+		static uint32_t desc[2];
+		desc[0] = (uint32_t)va_to_pa(buf);
+		desc[1] = len;
+		/* NEMU reads the memory when the port is written */
+		asm volatile("" : : : "memory");
+		out_long(CONSOLE_PORT, (uint32_t)va_to_pa(desc));
+		return;
+	}
+
+	while (len > 0) {
+		int n = (len > FIFO_SIZE ? FIFO_SIZE : len);
+		while (!serial_idle());
+		out_bytes(SERIAL_PORT, buf, n);
+		buf += n;
+		len -= n;
+	}
+}
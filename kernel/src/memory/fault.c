@@ -0,0 +1,109 @@
+#include "common.h"
+#include "memory.h"
+#include <string.h>
+
+/* The user address space is made of areas whose pages are filled when
+ * they are first touched: the ELF segments and mmap() areas from the
+ * disk, and the heap and the stack with zeros. A page may be shared by
+ * several areas, such as the end of the .bss and the start of the heap.
+ * The pages which must not fault are filled at once by mm_populate().
+ */
+
+#define NR_AREA 32
+
+static MmArea area[NR_AREA];
+static int nr_area = 0;
+
+PDE* get_updir();
+uint32_t get_ucr3();
+
+#ifdef HAS_DEVICE
+void ide_read(uint8_t *, uint32_t, uint32_t);
+#define disk_read ide_read
+#else
+void ramdisk_read(uint8_t *, uint32_t, uint32_t);
+#define disk_read ramdisk_read
+#endif
+
+/* [start, start + file_size) is read from ``disk_offset'' on the disk,
+ * and [start + file_size, end) is zero.
+ */
+MmArea *mm_add_area(uint32_t start, uint32_t end, uint32_t disk_offset, uint32_t file_size, bool writable) {
+	assert(nr_area < NR_AREA);
+	MmArea *a = &area[nr_area ++];
+	a->start = start;
+	a->end = end;
+	a->disk_offset = disk_offset;
+	a->file_size = (file_size < end - start ? file_size : end - start);
+	a->writable = writable;
+	return a;
+}
+
+/* The PTE of the user address ``addr'', or NULL without a page table. */
+PTE *get_upte(uint32_t addr) {
+	PDE *pde = &get_updir()[addr >> 22];
+	if(!pde->present) { return NULL; }
+	PTE *pt = pa_to_va(pde->page_frame << 12);
+	return &pt[(addr >> 12) & (NR_PTE - 1)];
+}
+
+/* Fill the page at ``addr'' from the areas covering it. Return false
+ * if no area does, or if the page is present and the fault is a
+ * write to a read-only page.
+ */
+bool mm_fault(uint32_t addr) {
+	uint32_t page = addr & ~PAGE_MASK;
+	bool found = false, writable = false;
+	int i;
+	PTE *pte = get_upte(page);
+	if(pte != NULL && pte->present) { return false; }
+
+	for(i = 0; i < nr_area; i ++) {
+		if(addr >= area[i].start && addr < area[i].end) { found = true; }
+	}
+	if(!found) { return false; }
+
+	mm_malloc(page, PAGE_SIZE);
+	pte = get_upte(page);
+	assert(pte != NULL && pte->present);
+
+	/* A page filled by the file of one area is not zeroed first. */
+	for(i = 0; i < nr_area; i ++) {
+		if(area[i].start <= page && area[i].start + area[i].file_size >= page + PAGE_SIZE) { break; }
+	}
+	if(i == nr_area) {
+		memset((void *)page, 0, PAGE_SIZE);
+	}
+
+	for(i = 0; i < nr_area; i ++) {
+		MmArea *a = &area[i];
+		if(a->end <= page || a->start >= page + PAGE_SIZE) { continue; }
+		writable |= a->writable;
+
+		/* the part of the file in this page */
+		uint32_t lo = (a->start > page ? a->start : page);
+		uint32_t hi = a->start + a->file_size;
+		if(hi > page + PAGE_SIZE) { hi = page + PAGE_SIZE; }
+		if(lo < hi) {
+			disk_read((void *)lo, a->disk_offset + (lo - a->start), hi - lo);
+		}
+	}
+
+	if(!writable) {
+		pte->read_write = 0;
+		write_cr3(get_ucr3());
+	}
+
+	return true;
+}
+
+/* Fill the pages of [start, end) now, for the memory which must not
+ * fault: the stack, on which a #PF is raised, and every area without
+ * IA32_INTR. The user page directory must be loaded.
+ */
+void mm_populate(uint32_t start, uint32_t end) {
+	uint32_t page;
+	for(page = start & ~PAGE_MASK; page < end; page += PAGE_SIZE) {
+		mm_fault(page);
+	}
+}
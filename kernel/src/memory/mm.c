@@ -12,10 +12,25 @@ static CR3 ucr3;
 
 uint32_t brk = 0;
 
-/* The brk() system call handler. */
+static MmArea *heap = NULL;
+
+/* The brk() system call handler. The heap is an area of zero pages
+ * starting at the first program break, filled on page fault, or at
+ * once without IA32_INTR.
+ */
 void mm_brk(uint32_t new_brk) {
-	if(new_brk > brk) {
-		mm_malloc(brk, new_brk - brk);
+	if(heap == NULL) {
+		heap = mm_add_area(brk, brk, 0, 0, true);
+	}
+	if(new_brk > heap->end) {
+#ifndef IA32_INTR
+		/* mm_fault() fills only the pages inside an area */
+		uint32_t old_end = heap->end;
+		heap->end = new_brk;
+		mm_populate(old_end, new_brk);
+#else
+		heap->end = new_brk;
+#endif
 	}
 	brk = new_brk;
 }
@@ -29,6 +44,8 @@ void init_mm() {
 	/* create the same mapping above 0xc0000000 as the kernel mapping does */
 	memcpy(&updir[KOFFSET / PT_SIZE], &kpdir[KOFFSET / PT_SIZE], 
 			(PHY_MEM / PT_SIZE) * sizeof(PDE));
+	memcpy(&updir[(KOFFSET + RAMDISK_BASE) / PT_SIZE], &kpdir[(KOFFSET + RAMDISK_BASE) / PT_SIZE],
+			(RAMDISK_MAX_SIZE / PT_SIZE) * sizeof(PDE));
 
 	ucr3.val = (uint32_t)va_to_pa((uint32_t)updir) & ~0x3ff;
 }
@@ -0,0 +1,53 @@
+#include "common.h"
+#include "memory.h"
+
+/* mmap() maps a file of file_table read-only into the user address
+ * space. With paging, it becomes an area whose pages are filled from
+ * the disk when they are first touched (see fault.c), so the parts of
+ * a file which are never used are never read (without IA32_INTR, the
+ * area is read at once). Without paging and devices, the file is used
+ * in place in the ramdisk window.
+ */
+
+#define MMAP_START   0x40000000
+#define MMAP_END     0x80000000
+
+#define PROT_WRITE   0x2
+
+#ifdef IA32_PAGE
+static uint32_t mmap_brk = MMAP_START;
+#endif
+
+bool fs_disk_range(int, uint32_t *, uint32_t *);
+
+#ifndef HAS_DEVICE
+uint8_t *ramdisk_ptr(uint32_t);
+#endif
+
+/* Return the address of the mapping, or -1 on failure. */
+uint32_t mm_mmap(uint32_t len, int prot, int fd, uint32_t offset) {
+	uint32_t disk_offset, size;
+	if(!fs_disk_range(fd, &disk_offset, &size) || (prot & PROT_WRITE) ||
+			(offset & PAGE_MASK) || offset > size) {
+		return -1;
+	}
+
+#ifdef IA32_PAGE
+	len = (len + PAGE_MASK) & ~PAGE_MASK;
+	if(len > MMAP_END - mmap_brk) {
+		return -1;
+	}
+
+	uint32_t start = mmap_brk;
+	mm_add_area(start, start + len, disk_offset + offset, size - offset, false);
+#ifndef IA32_INTR
+	mm_populate(start, start + len);
+#endif
+	mmap_brk += len;
+	return start;
+#elif !defined(HAS_DEVICE)
+	return (uint32_t)ramdisk_ptr(disk_offset + offset);
+#else
+	return -1;
+#endif
+}
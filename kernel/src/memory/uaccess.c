@@ -0,0 +1,81 @@
+#include "common.h"
+#include "memory.h"
+
+/* Access to the user memory from the kernel. The user page table is
+ * walked once for each run of pages which are contiguous in the physical
+ * memory, and the pages not present yet are filled on the way, so the
+ * kernel never faults on the user memory. Without paging, the user
+ * memory is used in place.
+ */
+
+/* Find the run of user memory from ``addr'', no longer than ``len'',
+ * which is contiguous in the kernel address space, and writable if
+ * ``is_write''. Return its length and its kernel address in ``kaddr'',
+ * or 0 if ``addr'' is not mapped (or is read-only for ``is_write'').
+ */
+uint32_t user_run(uint32_t addr, uint32_t len, bool is_write, void **kaddr) {
+#ifdef IA32_PAGE
+	uint32_t n = 0, next_pa = 0;
+	if(addr >= KOFFSET || len > KOFFSET - addr) { return 0; }
+
+	while(n < len) {
+		uint32_t va = addr + n;
+		PTE *pte = get_upte(va);
+		if(pte == NULL || !pte->present) {
+			if(!mm_fault(va)) { break; }
+			pte = get_upte(va);
+		}
+		/* The run is accessed through the kernel mapping, so check it by hand. */
+		if(is_write && !pte->read_write) { break; }
+
+		uint32_t pa = (pte->page_frame << 12) | (va & PAGE_MASK);
+		if(n == 0) { *kaddr = pa_to_va(pa); }
+		else if(pa != next_pa) { break; }
+
+		uint32_t step = PAGE_SIZE - (va & PAGE_MASK);
+		if(step > len - n) { step = len - n; }
+		n += step;
+		next_pa = pa + step;
+	}
+	return n;
+#else
+	*kaddr = (void *)addr;
+	return len;
+#endif
+}
+
+static inline void copy_run(void *dst, const void *src, uint32_t len) {
+	uint32_t nr_long = len >> 2;
+	asm volatile ("cld; rep movsl; movl %3, %%ecx; rep movsb"
+			: "+D"(dst), "+S"(src), "+c"(nr_long)
+			: "r"(len & 3) : "memory");
+}
+
+/* Return 0, or -1 if part of the user memory is not mapped, or is
+ * read-only for copy_to_user().
+ */
+int copy_from_user(void *dst, uint32_t src, uint32_t len) {
+	while(len > 0) {
+		void *kaddr;
+		uint32_t n = user_run(src, len, false, &kaddr);
+		if(n == 0) { return -1; }
+		copy_run(dst, kaddr, n);
+		dst += n;
+		src += n;
+		len -= n;
+	}
+	return 0;
+}
+
+int copy_to_user(uint32_t dst, const void *src, uint32_t len) {
+	while(len > 0) {
+		void *kaddr;
+		uint32_t n = user_run(dst, len, true, &kaddr);
+		if(n == 0) { return -1; }
+		copy_run(kaddr, src, n);
+		dst += n;
+		src += n;
+		len -= n;
+	}
+	return 0;
+}
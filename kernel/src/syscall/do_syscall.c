@@ -2,9 +2,17 @@
 
 #include <sys/syscall.h>
 
-void add_irq_handle(int, void (*)(void));
+int add_irq_handle(int, void (*)(void));
 void mm_brk(uint32_t);
 
+int fs_open(const char *, int);
+int fs_read(int, void *, int);
+int fs_write(int, void *, int);
+off_t fs_lseek(int, off_t, int);
+int fs_close(int);
+uint32_t mm_mmap(uint32_t, int, int, uint32_t);
+int copy_from_user(void *, uint32_t, uint32_t);
+
 static void sys_brk(TrapFrame *tf) {
 #ifdef IA32_PAGE
 	mm_brk(tf->ebx);
@@ -12,6 +20,19 @@ static void sys_brk(TrapFrame *tf) {
 	tf->eax = 0;
 }
 
+/* The old mmap() of i386, whose arguments are in a block at ``ebx'':
+ * addr, len, prot, flags, fd and offset. The address is always chosen
+ * by the kernel.
+ */
+static void sys_mmap(TrapFrame *tf) {
+	uint32_t args[6];
+	if(copy_from_user(args, tf->ebx, sizeof(args)) != 0) {
+		tf->eax = -1;
+		return;
+	}
+	tf->eax = mm_mmap(args[1], args[2], args[4], args[5]);
+}
+
 void do_syscall(TrapFrame *tf) {
 	switch(tf->eax) {
 		/* The ``add_irq_handle'' system call is artificial. We use it to 
@@ -19,13 +40,15 @@ void do_syscall(TrapFrame *tf) {
 		 * very dangerous in a real operating system. Therefore such a 
 		 * system call never exists in GNU/Linux.
 		 */
-		case 0: 
-			cli();
-			add_irq_handle(tf->ebx, (void*)tf->ecx);
-			sti();
-			break;
+		case 0: tf->eax = add_irq_handle(tf->ebx, (void*)tf->ecx); break;
 
 		case SYS_brk: sys_brk(tf); break;
+		case SYS_open: tf->eax = fs_open((void *)tf->ebx, tf->ecx); break;
+		case SYS_read: tf->eax = fs_read(tf->ebx, (void *)tf->ecx, tf->edx); break;
+		case SYS_write: tf->eax = fs_write(tf->ebx, (void *)tf->ecx, tf->edx); break;
+		case SYS_lseek: tf->eax = fs_lseek(tf->ebx, tf->ecx, tf->edx); break;
+		case SYS_close: tf->eax = fs_close(tf->ebx); break;
+		case SYS_mmap: sys_mmap(tf); break;
 
 		/* TODO: Add more system calls. */
 
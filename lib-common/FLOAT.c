@@ -5,19 +5,10 @@ FLOAT F_mul_F(FLOAT a, FLOAT b) {
 }
 
 FLOAT F_div_F(FLOAT a, FLOAT b) {
-    long long A = Fabs(a) << 16;
-    long long B = Fabs(b) << 16;
-    int c = 16;
-    FLOAT ans = 0;
-    for(; A; B>>=1, c--) {
-        if (A >= B) {
-            A = A - B;
-            ans = ans | (1 << c);
-        }
-        if (c == 0) break;
-    }
-    if ((long long)a*(long long)b < 0) ans = -ans;
-    return ans;
+	/* divide the 64-bit (a << 16) by b, which needs no libgcc */
+	FLOAT q, r;
+	asm volatile ("idiv %2" : "=a"(q), "=d"(r) : "r"(b), "a"(a << 16), "d"(a >> 16));
+	return q;
 }
 
 FLOAT f2F(float a) {
@@ -0,0 +1,39 @@
+#include <stddef.h>
+
+/* The string routines of newlib done by the hypercall of NEMU, which
+ * runs them natively instead of instruction by instruction. Linked
+ * before libc.a, they take the place of the ones in newlib, which also
+ * call them. The segment of ``edi'' is ES, the same as DS here.
+ */
+
+#define HYPERCALL ".byte 0xf1"
+
+#define HC_MEMCPY 1
+#define HC_MEMSET 2
+#define HC_MEMCMP 3
+#define HC_STRLEN 4
+
+void *memcpy(void *dst, const void *src, size_t n) {
+	void *d = dst;
+	asm volatile (HYPERCALL : "+D"(d), "+S"(src), "+c"(n) : "a"(HC_MEMCPY) : "memory");
+	return dst;
+}
+
+void *memset(void *s, int c, size_t n) {
+	void *d = s;
+	asm volatile (HYPERCALL : "+D"(d), "+c"(n) : "a"(HC_MEMSET), "d"(c) : "memory");
+	return s;
+}
+
+int memcmp(const void *s1, const void *s2, size_t n) {
+	int ret;
+	asm volatile (HYPERCALL : "=a"(ret), "+S"(s1), "+D"(s2), "+c"(n) : "0"(HC_MEMCMP) : "memory");
+	return ret;
+}
+
+size_t strlen(const char *s) {
+	const char *p = s;
+	int dummy;
+	asm volatile (HYPERCALL : "+D"(p), "=a"(dummy) : "1"(HC_STRLEN) : "memory");
+	return p - s;
+}
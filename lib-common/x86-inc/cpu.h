@@ -34,4 +34,14 @@ typedef union CR3 {
 	uint32_t val;
 } CR3;
 
+/* the Control Register 4 */
+typedef union CR4 {
+	struct {
+		uint32_t pad0                : 4;
+		uint32_t page_size_extension : 1;
+		uint32_t pad1                : 27;
+	};
+	uint32_t val;
+} CR4;
+
 #endif
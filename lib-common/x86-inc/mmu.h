@@ -46,7 +46,9 @@ typedef union PageDirectoryEntry {
 		uint32_t page_write_through  : 1;
 		uint32_t page_cache_disable  : 1;
 		uint32_t accessed            : 1;
-		uint32_t pad0                : 6;
+		uint32_t pad0                : 1;
+		uint32_t page_size           : 1;
+		uint32_t pad1                : 4;
 		uint32_t page_frame          : 20;
 	};
 	uint32_t val;
@@ -9,6 +9,15 @@
 #define DEBUG
 #define LOG_FILE
 
+/* Uncomment to count executions and host cycles per opcode (see `info s'). */
+//#define OPCODE_STAT
+
+/* Uncomment to drive the timing of devices by a virtual clock (see cpu/clock.h). */
+//#define VIRTUAL_CLOCK
+
+/* Uncomment to load the program in NEMU and run it without the kernel (see monitor/boot.c). */
+//#define DIRECT_BOOT
+
 #include "debug.h"
 #include "macro.h"
 
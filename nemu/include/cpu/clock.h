@@ -0,0 +1,28 @@
+#ifndef __CLOCK_H__
+#define __CLOCK_H__
+
+#include "common.h"
+
+/* The virtual clock counts the cycles of the guest CPU. Each instruction
+ * costs the cycles of its class, and each DRAM burst costs the latency of
+ * a row buffer hit or miss (see dram.c). With devices, the timer, the
+ * screen refresh and the IDE latency are driven by this clock instead of
+ * the host time (see device/event.h), so the execution is reproducible.
+ */
+
+#define CPU_HZ 100000000
+
+#ifdef VIRTUAL_CLOCK
+
+extern uint64_t vclock;
+extern const uint8_t instr_cycles[];
+
+#define clock_advance(cycles) (vclock += (cycles))
+
+#else
+
+#define clock_advance(cycles)
+
+#endif
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef __INTR_H__
+#define __INTR_H__
+
+#include "common.h"
+
+/* the state at the start of the current instruction, to restart it after a fault */
+extern swaddr_t instr_eip;
+extern uint32_t instr_esp;
+
+void raise_intr(uint8_t);
+void raise_exception(uint8_t, uint32_t);
+void return_from_intr();
+void intr_check();
+void intr_deliver();
+
+#endif
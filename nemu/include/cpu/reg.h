@@ -6,6 +6,18 @@
 enum { R_EAX, R_ECX, R_EDX, R_EBX, R_ESP, R_EBP, R_ESI, R_EDI };
 enum { R_AX, R_CX, R_DX, R_BX, R_SP, R_BP, R_SI, R_DI };
 enum { R_AL, R_CL, R_DL, R_BL, R_AH, R_CH, R_DH, R_BH };
+enum { R_ES, R_CS, R_SS, R_DS };
+
+/* A segment register, with the hidden part loaded from the descriptor
+ * when the selector is written. ``flat'' is set for base 0 and a 4GB
+ * limit, where the address needs no translation. A null selector makes
+ * the segment unusable: every access through it raises #GP.
+ */
+typedef struct {
+	uint16_t val;
+	uint32_t base, limit;
+	bool flat, usable;
+} SegReg;
 
 /* TODO: Re-organize the `CPU_state' structure to match the register
  * encoding scheme in i386 instruction format. For example, if we
@@ -32,33 +44,68 @@ typedef struct {
     #define edi gpr[7]._32
     swaddr_t eip;
 
+	/* The flags are laid out as in EFLAGS, so ``eflags'' can be pushed
+	 * and popped as a whole.
+	 */
 	union{
 		struct{
 			uint32_t CF: 1;
-			uint32_t: 0;
+			uint32_t : 1;
 			uint32_t PF: 1;
-			uint32_t: 0;
+			uint32_t : 1;
 			uint32_t AF: 1;
-			uint32_t : 0;
+			uint32_t : 1;
 			uint32_t ZF: 1;
 			uint32_t SF: 1;
 			uint32_t TF: 1;
 			uint32_t IF: 1;
 			uint32_t DF: 1;
 			uint32_t OF: 1;
-			uint32_t IOPL: 1;
+			uint32_t IOPL: 2;
 			uint32_t NT: 1;
-			uint32_t : 0;
+			uint32_t : 1;
 			uint32_t RF: 1;
 			uint32_t VM: 1;
+			uint32_t : 14;
 		};
 		uint32_t eflags;
 	};
 
+	SegReg sreg[4];
+
+	/* global descriptor table register */
+	struct {
+		uint16_t limit;
+		uint32_t base;
+	} gdtr;
+
+	/* control registers */
+	uint32_t cr0, cr2, cr3, cr4;
+
+	/* interrupt descriptor table register */
+	struct {
+		uint16_t limit;
+		uint32_t base;
+	} idtr;
+
+	/* the INTR pin, driven by the i8259 */
+	bool INTR;
+
+	/* stopped by ``hlt'' until an interrupt is taken */
+	bool halted;
+
+	/* the number of retired instructions */
+	uint64_t instr_cnt;
+
 } CPU_state;
 
 extern CPU_state cpu;
 
+#define CR0_PE 0x00000001
+#define CR0_WP 0x00010000
+#define CR0_PG 0x80000000
+#define CR4_PSE 0x00000010
+
 static inline int check_reg_index(int index) {
 	assert(index >= 0 && index < 8);
 	return index;
@@ -71,5 +118,8 @@ static inline int check_reg_index(int index) {
 extern const char* regsl[];
 extern const char* regsw[];
 extern const char* regsb[];
+extern const char* regss[];
+
+void load_sreg(int, uint16_t);
 
 #endif
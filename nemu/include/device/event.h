@@ -0,0 +1,60 @@
+#ifndef __EVENT_H__
+#define __EVENT_H__
+
+#include "common.h"
+#include "cpu/clock.h"
+#include "cpu/reg.h"
+
+/* Device events are kept in a timer wheel. The CPU loop only compares
+ * the current time with ``event_deadline'', the time of the nearest
+ * event, and calls event_dispatch() when it is reached. The CPU loop
+ * also lowers it to its own deadlines, counted in instructions, such as
+ * the next replay event and the next checkpoint (see cpu-exec.c).
+ *
+ * Anything else that must be looked at between two instructions, such
+ * as an interrupt that may have become deliverable or one of those
+ * deadlines moved earlier, calls event_kick() to take the CPU loop off
+ * this single check for one instruction.
+ *
+ * The time is counted in cycles of the virtual clock if VIRTUAL_CLOCK
+ * is defined, or in retired instructions otherwise, plus the time the
+ * CPU has been idle in ``hlt'', which retires no instruction.
+ */
+
+#ifdef VIRTUAL_CLOCK
+#define event_now() vclock
+#else
+extern uint64_t event_idle;
+#define event_now() (cpu.instr_cnt + event_idle)
+#endif
+
+typedef struct Event {
+	uint64_t when;
+	void (*handler)();
+	bool pending;
+	struct Event *next;
+} Event;
+
+extern uint64_t event_deadline;
+
+static inline void event_kick() {
+	event_deadline = 0;
+}
+
+/* Move the time forward to ``when'' while the CPU is idle. */
+static inline void event_idle_until(uint64_t when) {
+	if(when > event_now()) {
+#ifdef VIRTUAL_CLOCK
+		vclock = when;
+#else
+		event_idle += when - event_now();
+#endif
+	}
+}
+
+/* Call ``ev->handler'' after ``delay'' units of time. */
+void event_add(Event *ev, uint64_t delay);
+void event_del(Event *ev);
+void event_dispatch();
+
+#endif
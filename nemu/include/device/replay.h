@@ -0,0 +1,28 @@
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+
+#include "common.h"
+
+enum { REPLAY_OFF, REPLAY_RECORD, REPLAY_PLAY };
+enum { EV_TIMER, EV_KEYBOARD, EV_IDE };
+
+extern int replay_mode;
+
+/* The instruction count at which replay_dispatch() should be called. */
+extern uint64_t replay_deadline;
+
+bool replay_start(int, const char *);
+void replay_stop();
+void replay_dispatch();
+
+extern bool journal_on;
+
+void journal_start();
+void journal_stop();
+void journal_trim(uint64_t);
+void journal_rewind(uint64_t);
+
+void device_event(int, uint32_t);
+void device_sync_event(int, uint32_t);
+
+#endif
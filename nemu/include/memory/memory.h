@@ -7,6 +7,21 @@
 
 extern uint8_t *hw_mem;
 
+#ifdef USE_RAMDISK
+/* The ramdisk is a window of physical memory right above the DRAM, where
+ * the program file is mapped with mmap() instead of being copied.
+ */
+#define RAMDISK_BASE HW_MEM_SIZE
+#define RAMDISK_MAX_SIZE (64 * 1024 * 1024)
+
+extern uint8_t *ramdisk;
+
+#define ramdisk_rw(addr, type) *(type *)({\
+	Assert(ramdisk != NULL && addr - RAMDISK_BASE < RAMDISK_MAX_SIZE, "physical address(0x%08x) is out of bound", addr); \
+	ramdisk + (addr - RAMDISK_BASE); \
+})
+#endif
+
 /* convert the hardware address in the test program to virtual address in NEMU */
 #define hwa_to_va(p) ((void *)(hw_mem + (unsigned)p))
 /* convert the virtual address in NEMU to hardware address in the test program */
@@ -17,11 +32,16 @@ extern uint8_t *hw_mem;
 	hwa_to_va(addr); \
 })
 
-uint32_t swaddr_read(swaddr_t, size_t);
+uint32_t swaddr_read(swaddr_t, size_t, uint8_t);
 uint32_t lnaddr_read(lnaddr_t, size_t);
 uint32_t hwaddr_read(hwaddr_t, size_t);
-void swaddr_write(swaddr_t, size_t, uint32_t);
+void swaddr_write(swaddr_t, size_t, uint32_t, uint8_t);
 void lnaddr_write(lnaddr_t, size_t, uint32_t);
 void hwaddr_write(hwaddr_t, size_t, uint32_t);
+void *swaddr_host_ptr(swaddr_t, size_t *, bool, uint8_t);
+bool swaddr_debug_read(swaddr_t, size_t, uint8_t, uint32_t *);
+bool swaddr_debug_write(swaddr_t, size_t, uint32_t, uint8_t);
+
+void page_flush();
 
 #endif
@@ -0,0 +1,26 @@
+#ifndef __GDB_H__
+#define __GDB_H__
+
+#include "common.h"
+
+#define GDB_BP_MAP_SIZE 4096
+
+/* gdb_bp_map[eip % GDB_BP_MAP_SIZE] is the number of breakpoints whose
+ * address falls into that slot, so the CPU loop only pays one load per
+ * instruction when the slot is empty, and only tests ``gdb_nr_bp''
+ * when there is no breakpoint at all.
+ */
+extern uint8_t gdb_bp_map[];
+extern int gdb_nr_bp;
+extern bool gdb_watch_on;
+
+bool gdb_bp_hit(swaddr_t);
+void gdb_watch_write(swaddr_t, size_t);
+
+static inline bool gdb_check_bp(swaddr_t eip) {
+	return gdb_nr_bp != 0 && gdb_bp_map[eip & (GDB_BP_MAP_SIZE - 1)] != 0 && gdb_bp_hit(eip);
+}
+
+void gdb_serve(const char *);
+
+#endif
@@ -1,7 +1,14 @@
 #ifndef __MONITOR_H__
 #define __MONITOR_H__
 
+#include "common.h"
+
 enum { STOP, RUNNING, END };
 extern int nemu_state;
 
+/* Suppress messages while re-executing for reverse execution. */
+extern bool nemu_quiet;
+
+void print_exec_stat();
+
 #endif
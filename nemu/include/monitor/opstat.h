@@ -0,0 +1,22 @@
+#ifndef __OPSTAT_H__
+#define __OPSTAT_H__
+
+#include "common.h"
+
+#ifdef OPCODE_STAT
+
+/* Read the time stamp counter of the host. */
+static inline uint64_t rdtsc() {
+	uint32_t lo, hi;
+	asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+	return ((uint64_t)hi << 32) | lo;
+}
+
+void opstat_modrm(int);
+void opstat_record(uint32_t, uint64_t);
+void opstat_report();
+void opstat_reset();
+
+#endif
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef __REVERSE_H__
+#define __REVERSE_H__
+
+#include "common.h"
+#include "memory/memory.h"
+#include "cpu/reg.h"
+
+#define REV_PAGE_SHIFT 12
+#ifdef USE_RAMDISK
+/* the DRAM and the ramdisk window above it */
+#define REV_MEM_SIZE (RAMDISK_BASE + RAMDISK_MAX_SIZE)
+#else
+#define REV_MEM_SIZE HW_MEM_SIZE
+#endif
+#define REV_NR_PAGE (REV_MEM_SIZE >> REV_PAGE_SHIFT)
+
+extern bool rev_on;
+extern uint64_t rev_next_checkpoint;
+extern uint8_t rev_page_saved[];
+extern uint64_t rev_barrier;
+
+void rev_start(uint64_t, size_t);
+void rev_stop();
+void rev_step(uint64_t);
+void rev_continue();
+void rev_info();
+
+void rev_checkpoint();
+void rev_save_page(hwaddr_t);
+
+/* Called before DRAM or the ramdisk is written. The first write to a
+ * page after a checkpoint saves the old content of the page into the
+ * checkpoint.
+ */
+static inline void rev_track_write(hwaddr_t addr, size_t len) {
+	if(addr + len > REV_MEM_SIZE) { return; }
+	if(!rev_page_saved[addr >> REV_PAGE_SHIFT]) { rev_save_page(addr); }
+	if(!rev_page_saved[(addr + len - 1) >> REV_PAGE_SHIFT]) { rev_save_page(addr + len - 1); }
+}
+
+/* Called when the guest accesses a device, or when a device finishes a
+ * request of the guest. The state of the devices is not checkpointed, so
+ * the machine is never rolled back past such an instruction.
+ */
+static inline void rev_device_access() {
+	rev_barrier = cpu.instr_cnt + 1;
+}
+
+#endif
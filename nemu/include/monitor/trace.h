@@ -0,0 +1,77 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include "common.h"
+
+/* Binary execution trace.
+ *
+ * A trace file starts with a header, followed by a stream of records.
+ * Every record begins with a tag byte:
+ *
+ *   1ffl llll  instruction, l = instruction length
+ *              f = TRACE_HAS_BYTES: the instruction bytes follow
+ *              f = TRACE_HAS_REGS:  changed registers follow
+ *   0000 0lll  memory write of l bytes, issued by the next instruction
+ *
+ * An instruction record then contains the zigzag varint of
+ * ``eip - expected eip'', where the expected eip is the end of the
+ * previous instruction, so straight-line code costs a single byte.
+ * If TRACE_HAS_BYTES is set, the raw instruction bytes follow. If
+ * TRACE_HAS_REGS is set, a varint bitmap of changed registers follows
+ * (bit 0 ~ 7 for GPRs, bit 8 for EFLAGS), then the new value of every
+ * changed register as a varint.
+ *
+ * A memory write record contains the zigzag varint of the distance to
+ * the address of the previous memory write, then the data as a varint.
+ */
+
+#define TRACE_MAGIC "NEMUTRC1"
+
+#define TRACE_TAG_INSTR 0x80
+#define TRACE_HAS_BYTES 0x40
+#define TRACE_HAS_REGS 0x20
+#define TRACE_LEN_MASK 0x1f
+#define TRACE_TAG_MEM_MASK 0x07
+
+/* options in the header */
+#define TRACE_OPT_REGS 0x1
+#define TRACE_OPT_MEM 0x2
+
+#define TRACE_REG_EFLAGS 8
+#define TRACE_NR_REG 9
+
+typedef struct {
+	char magic[8];
+	uint32_t options;
+	uint32_t start_eip;
+	uint32_t start_regs[TRACE_NR_REG];
+} TraceHeader;
+
+static inline uint32_t zigzag_encode(int32_t v) {
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline int32_t zigzag_decode(uint32_t v) {
+	return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* Write ``v'' as a varint to ``p'', return the number of bytes written. */
+static inline int varint_encode(uint8_t *p, uint32_t v) {
+	int n = 0;
+	while(v >= 0x80) {
+		p[n ++] = v | 0x80;
+		v >>= 7;
+	}
+	p[n ++] = v;
+	return n;
+}
+
+extern bool trace_on;
+extern bool trace_mem_on;
+
+bool trace_start(const char *, uint32_t);
+void trace_stop();
+void trace_instr(swaddr_t, int);
+void trace_mem_write(swaddr_t, size_t, uint32_t);
+
+#endif
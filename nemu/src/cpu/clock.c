@@ -0,0 +1,31 @@
+#include "cpu/clock.h"
+
+#ifdef VIRTUAL_CLOCK
+
+uint64_t vclock = 0;
+
+/* The cycles of each opcode, indexed by ``ops_decoded.opcode''. Memory
+ * accesses are charged by dram.c, so these are the execution cycles only.
+ */
+const uint8_t instr_cycles[512] = {
+	[0x000 ... 0x1ff] = 1,
+
+	/* branch, call and return */
+	[0x070 ... 0x07f] = 2, [0x180 ... 0x18f] = 2,
+	[0x0e0 ... 0x0e3] = 2, [0x0e8 ... 0x0eb] = 2,
+	[0x0c2] = 2, [0x0c3] = 2, [0x0ca] = 2, [0x0cb] = 2,
+
+	/* multiply, and the group of mul/div */
+	[0x069] = 4, [0x06b] = 4, [0x1af] = 4,
+	[0x0f6] = 12, [0x0f7] = 12,
+
+	/* string operations, per iteration */
+	[0x0a4 ... 0x0a7] = 3, [0x0aa ... 0x0af] = 3,
+
+	/* port I/O, interrupts and system registers */
+	[0x0e4 ... 0x0e7] = 20, [0x0ec ... 0x0ef] = 20,
+	[0x0cc ... 0x0cf] = 20,
+	[0x101] = 10, [0x120 ... 0x123] = 10,
+};
+
+#endif
@@ -1,8 +1,12 @@
 #include "cpu/decode/modrm.h"
 #include "cpu/helper.h"
+#include "monitor/opstat.h"
 
 int load_addr(swaddr_t eip, ModR_M *m, Operand *rm) {
 	assert(m->mod != 3);
+#ifdef OPCODE_STAT
+	opstat_modrm(m->mod);
+#endif
 
 	int32_t disp;
 	int instr_len, disp_offset, disp_size = 4;
@@ -79,6 +83,7 @@ int load_addr(swaddr_t eip, ModR_M *m, Operand *rm) {
 
 	rm->type = OP_TYPE_MEM;
 	rm->addr = addr;
+	rm->sreg = (base_reg == R_ESP || base_reg == R_EBP ? R_SS : R_DS);
 
 	return instr_len;
 }
@@ -90,6 +95,9 @@ int read_ModR_M(swaddr_t eip, Operand *rm, Operand *reg) {
 	reg->reg = m.reg;
 
 	if(m.mod == 3) {
+#ifdef OPCODE_STAT
+		opstat_modrm(3);
+#endif
 		rm->type = OP_TYPE_REG;
 		rm->reg = m.R_M;
 		switch(rm->size) {
@@ -109,7 +117,7 @@ int read_ModR_M(swaddr_t eip, Operand *rm, Operand *reg) {
 	}
 	else {
 		int instr_len = load_addr(eip, &m, rm);
-		rm->val = swaddr_read(rm->addr, rm->size);
+		rm->val = swaddr_read(rm->addr, rm->size, rm->sreg);
 		return instr_len;
 	}
 }
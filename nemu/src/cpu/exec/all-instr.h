@@ -6,6 +6,7 @@
 #include "data-mov/movzx.h"
 #include "data-mov/push.h"
 #include "data-mov/pop.h"
+#include "data-mov/pusha.h"
 #include "data-mov/xchg.h"
 
 #include "arith/adc.h"
@@ -41,9 +42,14 @@
 
 #include "string/cmps.h"
 #include "string/movs.h"
+#include "string/outs.h"
 #include "string/rep.h"
 #include "string/stos.h"
 
+#include "io/in.h"
+#include "io/out.h"
+
 #include "misc/misc.h"
 
 #include "special/special.h"
+#include "system/system.h"
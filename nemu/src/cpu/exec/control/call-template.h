@@ -4,21 +4,27 @@
 
 static void do_execute() {
     cpu.esp -= 4;
-    if(op_src->type == OP_TYPE_IMM){
-        swaddr_write(cpu.esp, 4, cpu.eip + DATA_BYTE + 1);
-        cpu.eip += op_src->val;
-        if(DATA_BYTE == 2) cpu.eip &= 0x0000ffff;
-        print_asm("call $0x%x", cpu.eip + DATA_BYTE + 1);
-    }
-    else{
-        swaddr_write(cpu.esp, 4, cpu.eip + 2);
-        cpu.eip = (op_src->val) - 2;
-        print_asm("call $0x%x", cpu.eip + 2);
-    }
+    swaddr_write(cpu.esp, 4, cpu.eip + DATA_BYTE + 1, R_SS);
+    cpu.eip += op_src->val;
+    if(DATA_BYTE == 2) cpu.eip &= 0x0000ffff;
+    print_asm("call $0x%x", cpu.eip + DATA_BYTE + 1);
 }
 
-
 make_instr_helper(i)
-make_instr_helper(rm)
+
+/* The length of an indirect call depends on its ModR/M operand, such
+ * as 7 bytes for ``call *table(,%ebx,4)'', so the return address is
+ * made of the decoded length.
+ */
+make_helper(concat(call_rm_, SUFFIX)) {
+    int len = concat(decode_rm_, SUFFIX)(eip + 1) + 1;
+    cpu.esp -= 4;
+    swaddr_write(cpu.esp, 4, cpu.eip + len, R_SS);
+    cpu.eip = op_src->val;
+    if(DATA_BYTE == 2) cpu.eip &= 0x0000ffff;
+    print_asm("call *%s", op_src->str);
+    cpu.eip -= len;
+    return len;
+}
 
 #include "cpu/exec/template-end.h"
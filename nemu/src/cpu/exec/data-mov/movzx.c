@@ -8,10 +8,4 @@
 #include "movzx-template.h"
 #undef DATA_BYTE
 
-#define DATA_BYTE 4
-#include "movzx-template.h"
-#undef DATA_BYTE
-
 /* for instruction encoding overloading */
-
-make_helper_v(movzx_rm2r)
@@ -0,0 +1,29 @@
+#include "cpu/exec/helper.h"
+
+/* Only the 32-bit forms are implemented. */
+
+make_helper(pusha) {
+	uint32_t temp = cpu.esp;
+	int i;
+	for(i = R_EAX; i <= R_EDI; i ++) {
+		cpu.esp -= 4;
+		swaddr_write(cpu.esp, 4, (i == R_ESP ? temp : reg_l(i)), R_SS);
+	}
+
+	print_asm("pusha");
+	return 1;
+}
+
+make_helper(popa) {
+	int i;
+	for(i = R_EDI; i >= R_EAX; i --) {
+		/* the saved %esp is skipped */
+		if(i != R_ESP) {
+			reg_l(i) = swaddr_read(cpu.esp, 4, R_SS);
+		}
+		cpu.esp += 4;
+	}
+
+	print_asm("popa");
+	return 1;
+}
@@ -0,0 +1,7 @@
+#ifndef __PUSHA_H__
+#define __PUSHA_H__
+
+make_helper(pusha);
+make_helper(popa);
+
+#endif
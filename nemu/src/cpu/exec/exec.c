@@ -87,7 +87,7 @@ make_group(group6,
 		   inv, inv, inv, inv)
 
 make_group(group7,
-		   inv, inv, inv, inv,
+		   inv, inv, lgdt, lidt,
 		   inv, inv, inv, inv)
 
 
@@ -118,10 +118,10 @@ helper_fun opcode_table [256] = {
 /* 0x54 */	push_r_v, push_r_v, push_r_v, push_r_v,
 /* 0x58 */	pop_r_v, pop_r_v, pop_r_v, pop_r_v,
 /* 0x5c */	pop_r_v, pop_r_v, pop_r_v, pop_r_v,
-/* 0x60 */	inv, inv, inv, inv,
+/* 0x60 */	pusha, popa, inv, inv,
 /* 0x64 */	inv, inv, data_size, inv,
 /* 0x68 */	push_i_v, imul_i_rm2r_v, push_i_b, imul_si_rm2r_v,
-/* 0x6c */	inv, inv, inv, inv,
+/* 0x6c */	inv, inv, outs_b, outs_v,
 /* 0x70 */	jo_i_b, jno_i_b, jb_i_b, jae_i_b,
 /* 0x74 */	je_i_b, jne_i_b, jbe_i_b, ja_i_b,
 /* 0x78 */	js_i_b, jns_i_b, jp_i_b, jnp_i_b,
@@ -129,7 +129,7 @@ helper_fun opcode_table [256] = {
 /* 0x80 */	group1_b, group1_v, inv, group1_sx_v,
 /* 0x84 */	test_r2rm_b, test_r2rm_v, xchg_r2rm_b, xchg_r2rm_v,
 /* 0x88 */	mov_r2rm_b, mov_r2rm_v, mov_rm2r_b, mov_rm2r_v,
-/* 0x8c */	inv, lea, inv, pop_rm_v,
+/* 0x8c */	mov_sreg2rm, lea, mov_rm2sreg, pop_rm_v,
 /* 0x90 */	nop, inv, inv, inv,
 /* 0x94 */	inv, inv, inv, inv,
 /* 0x98 */	inv, cwd, inv, inv,
@@ -145,18 +145,18 @@ helper_fun opcode_table [256] = {
 /* 0xc0 */	group2_i_b, group2_i_v, ret_i_w, ret,
 /* 0xc4 */	inv, inv, mov_i2rm_b, mov_i2rm_v,
 /* 0xc8 */	inv, leave, ret_i_w, ret,
-/* 0xcc */	int3, inv, inv, inv,
+/* 0xcc */	int3, int_i, inv, iret,
 /* 0xd0 */	group2_1_b, group2_1_v, group2_cl_b, group2_cl_v,
 /* 0xd4 */	inv, inv, nemu_trap, inv,
 /* 0xd8 */	inv, inv, inv, inv,
 /* 0xdc */	inv, inv, inv, inv,
 /* 0xe0 */	inv, inv, inv, jcxz_i_b,
-/* 0xe4 */	inv, inv, inv, inv,
-/* 0xe8 */	call_i_v, jmp_i_v, inv, jmp_i_b,
-/* 0xec */	inv, inv, inv, inv,
-/* 0xf0 */	inv, inv, inv, rep,
-/* 0xf4 */	inv, inv, group3_b, group3_v,
-/* 0xf8 */	inv, inv, inv, inv,
+/* 0xe4 */	in_i2a_b, in_i2a_v, out_a2i_b, out_a2i_v,
+/* 0xe8 */	call_i_v, jmp_i_v, ljmp, jmp_i_b,
+/* 0xec */	in_d2a_b, in_d2a_v, out_a2d_b, out_a2d_v,
+/* 0xf0 */	inv, nemu_hypercall, inv, rep,
+/* 0xf4 */	hlt, inv, group3_b, group3_v,
+/* 0xf8 */	inv, inv, cli, sti,
 /* 0xfc */	cld, inv, group4, group5
 };
 
@@ -169,7 +169,7 @@ helper_fun _2byte_opcode_table [256] = {
 /* 0x14 */	inv, inv, inv, inv,
 /* 0x18 */	inv, inv, inv, inv,
 /* 0x1c */	inv, inv, inv, inv,
-/* 0x20 */	inv, inv, inv, inv,
+/* 0x20 */	mov_cr2r, inv, mov_r2cr, inv,
 /* 0x24 */	inv, inv, inv, inv,
 /* 0x28 */	inv, inv, inv, inv,
 /* 0x2c */	inv, inv, inv, inv,
@@ -206,7 +206,7 @@ helper_fun _2byte_opcode_table [256] = {
 /* 0xa8 */	inv, inv, inv, inv,
 /* 0xac */	shrdi_v, shrdi_v, inv, imul_rm2r_v,
 /* 0xb0 */	inv, inv, inv, inv,
-/* 0xb4 */	inv, inv, movzx_rm2r_b, movzx_rm2r_v,
+/* 0xb4 */	inv, inv, movzx_rm2r_b, movzx_rm2r_w,
 /* 0xb8 */	inv, inv, inv, inv,
 /* 0xbc */	inv, inv, movsx_rm2r_b, movsx_rm2r_w,
 /* 0xc0 */	inv, inv, inv, inv,
@@ -1,5 +1,7 @@
 #include "cpu/exec/helper.h"
 #include "monitor/monitor.h"
+#include "monitor/trace.h"
+#include "cpu/clock.h"
 
 make_helper(inv) {
 	/* invalid opcode */
@@ -24,19 +26,154 @@ make_helper(inv) {
 	assert(0);
 }
 
+#ifdef HAS_DEVICE
+void serial_flush();
+#endif
+
 make_helper(nemu_trap) {
 	print_asm("nemu trap (eax = %d)", cpu.eax);
 
 	switch(cpu.eax) {
-		case 2:
-		   	break;
+		case 2: {
+			/* print ``edx'' bytes at ``ecx'', for write() without a serial port */
+			uint32_t i;
+			for(i = 0; i < cpu.edx; i ++) {
+				putchar(swaddr_read(cpu.ecx + i, 1, R_DS));
+			}
+			fflush(stdout);
+			break;
+		}
 
 		default:
-			printf("\33[1;31mnemu: HIT %s TRAP\33[0m at eip = 0x%08x\n\n",
-					(cpu.eax == 0 ? "GOOD" : "BAD"), cpu.eip);
+#ifdef HAS_DEVICE
+			serial_flush();
+#endif
+			if(!nemu_quiet) {
+				/* cpu_exec() prints the statistics once the trap has retired */
+				printf("\33[1;31mnemu: HIT %s TRAP\33[0m at eip = 0x%08x\n",
+						(cpu.eax == 0 ? "GOOD" : "BAD"), cpu.eip);
+			}
 			nemu_state = END;
 	}
 
 	return 1;
 }
 
+
+/* The hypercall functions, with the number in ``eax''. Like the string
+ * instructions with ``rep'', ``esi'' and ``edi'' advance and ``ecx''
+ * counts down as the bytes are done, so a hypercall stopped by a page
+ * fault continues where it stopped once the fault is handled.
+ */
+enum {
+	HC_MEMCPY = 1,	/* copy ``ecx'' bytes from ds:esi to es:edi */
+	HC_MEMSET,		/* fill ``ecx'' bytes at es:edi with ``dl'' */
+	HC_MEMCMP,		/* compare ``ecx'' bytes at ds:esi and es:edi, the result in ``eax'' */
+	HC_STRLEN		/* advance ``edi'' to the first '\0' at es:edi */
+};
+
+void init_ddr3();
+
+#ifdef VIRTUAL_CLOCK
+void dram_charge_stream(size_t);
+#endif
+
+/* Charge ``n'' bytes done on ``nr_stream'' streams of memory as long as
+ * ``rep movsl'' would take: an iteration for every 4 bytes, and the DRAM
+ * bursts of each stream.
+ */
+static void hc_charge(size_t n, int nr_stream) {
+#ifdef VIRTUAL_CLOCK
+	clock_advance((n + 3) / 4 * instr_cycles[0xa5]);
+	while(nr_stream -- > 0) {
+		dram_charge_stream(n);
+	}
+#endif
+}
+
+static void hc_written(swaddr_t addr, uint8_t *p, size_t len) {
+	if(trace_mem_on) {
+		size_t i;
+		for(i = 0; i < len; i ++) {
+			trace_mem_write(addr + i, 1, p[i]);
+		}
+	}
+	/* DRAM is written behind the row buffers */
+	init_ddr3();
+}
+
+make_helper(nemu_hypercall) {
+	print_asm("nemu hypercall (eax = %d)", cpu.eax);
+
+	size_t n;
+	uint8_t *src, *dst;
+	switch(cpu.eax) {
+		case HC_MEMCPY:
+			while(cpu.ecx > 0) {
+				n = cpu.ecx;
+				src = swaddr_host_ptr(cpu.esi, &n, false, R_DS);
+				dst = swaddr_host_ptr(cpu.edi, &n, true, R_ES);
+				memmove(dst, src, n);
+				hc_written(cpu.edi, dst, n);
+				hc_charge(n, 2);
+				cpu.esi += n;
+				cpu.edi += n;
+				cpu.ecx -= n;
+			}
+			break;
+
+		case HC_MEMSET:
+			while(cpu.ecx > 0) {
+				n = cpu.ecx;
+				dst = swaddr_host_ptr(cpu.edi, &n, true, R_ES);
+				memset(dst, cpu.edx & 0xff, n);
+				hc_written(cpu.edi, dst, n);
+				hc_charge(n, 1);
+				cpu.edi += n;
+				cpu.ecx -= n;
+			}
+			break;
+
+		case HC_MEMCMP: {
+			int ret = 0;
+			while(cpu.ecx > 0) {
+				n = cpu.ecx;
+				src = swaddr_host_ptr(cpu.esi, &n, false, R_DS);
+				dst = swaddr_host_ptr(cpu.edi, &n, false, R_ES);
+				if(memcmp(src, dst, n) != 0) {
+					uint8_t *start = src;
+					while(*src == *dst) { src ++; dst ++; }
+					ret = *src - *dst;
+					hc_charge(src - start + 1, 2);
+					break;
+				}
+				hc_charge(n, 2);
+				cpu.esi += n;
+				cpu.edi += n;
+				cpu.ecx -= n;
+			}
+			cpu.eax = ret;
+			break;
+		}
+
+		case HC_STRLEN:
+			while(1) {
+				n = -1;	/* up to the end of the page */
+				dst = swaddr_host_ptr(cpu.edi, &n, false, R_ES);
+				uint8_t *end = memchr(dst, '\0', n);
+				if(end != NULL) {
+					hc_charge(end - dst + 1, 1);
+					cpu.edi += end - dst;
+					break;
+				}
+				hc_charge(n, 1);
+				cpu.edi += n;
+			}
+			cpu.eax = 0;
+			break;
+
+		default: panic("unknown hypercall %d at eip = 0x%08x", cpu.eax, cpu.eip);
+	}
+
+	return 1;
+}
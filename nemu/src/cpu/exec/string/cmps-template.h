@@ -3,7 +3,7 @@
 #define instr cmps
 
 make_helper(concat3(instr, _, SUFFIX)) {
-	if (swaddr_read(cpu.edi,  DATA_BYTE) == swaddr_read(cpu.esi, DATA_BYTE)) {
+	if (swaddr_read(cpu.edi, DATA_BYTE, R_ES) == swaddr_read(cpu.esi, DATA_BYTE, R_DS)) {
 		cpu.edi += (cpu.DF == 0 ? DATA_BYTE : -DATA_BYTE);
 		cpu.esi += (cpu.DF == 0 ? DATA_BYTE : -DATA_BYTE);
 		return 1;
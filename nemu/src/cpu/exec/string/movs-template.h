@@ -3,7 +3,7 @@
 #define instr movs
 
 make_helper(concat(movs_, SUFFIX)){
-	MEM_W(cpu.edi, MEM_R(cpu.esi));
+	MEM_W(cpu.edi, MEM_R(cpu.esi, R_DS), R_ES);
 	if(cpu.DF == 0){
 		cpu.esi += DATA_BYTE;
 		cpu.edi += DATA_BYTE;
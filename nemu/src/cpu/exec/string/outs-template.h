@@ -0,0 +1,17 @@
+#include "cpu/exec/template-start.h"
+
+#define instr outs
+
+make_helper(concat(outs_, SUFFIX)) {
+	pio_write(reg_w(R_DX), DATA_BYTE, MEM_R(cpu.esi, R_DS));
+	if(cpu.DF == 0) {
+		cpu.esi += DATA_BYTE;
+	}
+	else {
+		cpu.esi -= DATA_BYTE;
+	}
+	print_asm("outs" str(SUFFIX));
+	return 1;
+}
+
+#include "cpu/exec/template-end.h"
@@ -0,0 +1,6 @@
+#ifndef __OUTS_H__
+#define __OUTS_H__
+
+make_helper(outs_b);
+make_helper(outs_v);
+#endif
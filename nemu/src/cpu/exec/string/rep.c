@@ -1,4 +1,5 @@
 #include "cpu/exec/helper.h"
+#include "cpu/clock.h"
 
 make_helper(exec);
 
@@ -23,8 +24,13 @@ make_helper(rep) {
 				|| ops_decoded.opcode == 0xa7	// cmpsw
 				|| ops_decoded.opcode == 0xae	// scasb
 				|| ops_decoded.opcode == 0xaf	// scasw
+				|| ops_decoded.opcode == 0x6e	// outsb
+				|| ops_decoded.opcode == 0x6f	// outsw
 				);
 
+			/* Each iteration is charged; cpu_exec() charges the last one. */
+			if(cpu.ecx) { clock_advance(instr_cycles[ops_decoded.opcode]); }
+
 			/* TODO: Jump out of the while loop if necessary. */
 
 		}
@@ -3,7 +3,7 @@
 #define instr stos
 
 make_helper(concat(stos_, SUFFIX)){
-	MEM_W(cpu.edi, REG(R_EAX));
+	MEM_W(cpu.edi, REG(R_EAX), R_ES);
 	if(cpu.DF == 0) cpu.edi += DATA_BYTE;
 	else cpu.edi -= DATA_BYTE;
 	print_asm("stos" str(SUFFIX));
@@ -0,0 +1,152 @@
+#include "cpu/exec/helper.h"
+#include "cpu/decode/modrm.h"
+#include "cpu/intr.h"
+#include "device/event.h"
+
+make_helper(lgdt) {
+	ModR_M m;
+	m.val = instr_fetch(eip + 1, 1);
+	int len = load_addr(eip + 1, &m, op_src);
+	cpu.gdtr.limit = swaddr_read(op_src->addr, 2, op_src->sreg);
+	cpu.gdtr.base = swaddr_read(op_src->addr + 2, 4, op_src->sreg);
+
+	print_asm("lgdt %s", op_src->str);
+	return 1 + len;
+}
+
+make_helper(lidt) {
+	ModR_M m;
+	m.val = instr_fetch(eip + 1, 1);
+	int len = load_addr(eip + 1, &m, op_src);
+	cpu.idtr.limit = swaddr_read(op_src->addr, 2, op_src->sreg);
+	cpu.idtr.base = swaddr_read(op_src->addr + 2, 4, op_src->sreg);
+
+	print_asm("lidt %s", op_src->str);
+	return 1 + len;
+}
+
+/* Only ES, CS, SS and DS are implemented. */
+static int check_sreg_index(int index) {
+	Assert(index <= R_DS, "segment register %d is not implemented", index);
+	return index;
+}
+
+make_helper(mov_rm2sreg) {
+	op_src->size = 2;
+	int len = read_ModR_M(eip + 1, op_src, op_dest);
+	int sreg = check_sreg_index(op_dest->reg);
+	Assert(sreg != R_CS, "mov to %%cs");
+	load_sreg(sreg, op_src->val);
+
+	print_asm("movw %s,%%%s", op_src->str, regss[sreg]);
+	return 1 + len;
+}
+
+make_helper(mov_sreg2rm) {
+	op_dest->size = 2;
+	int len = read_ModR_M(eip + 1, op_dest, op_src);
+	int sreg = check_sreg_index(op_src->reg);
+	if(op_dest->type == OP_TYPE_REG) {
+		/* the upper bits are cleared with a 32-bit operand size */
+		reg_l(op_dest->reg) = cpu.sreg[sreg].val;
+	}
+	else {
+		swaddr_write(op_dest->addr, 2, cpu.sreg[sreg].val, op_dest->sreg);
+	}
+
+	print_asm("movw %%%s,%s", regss[sreg], op_dest->str);
+	return 1 + len;
+}
+
+make_helper(ljmp) {
+	uint32_t addr = instr_fetch(eip + 1, 4);
+	uint16_t sel = instr_fetch(eip + 5, 2);
+	load_sreg(R_CS, sel);
+	cpu.eip = addr;
+
+	print_asm("ljmp $0x%x,$0x%x", sel, addr);
+	return 0;
+}
+
+static uint32_t *control_reg(int n) {
+	switch(n) {
+		case 0: return &cpu.cr0;
+		case 2: return &cpu.cr2;
+		case 3: return &cpu.cr3;
+		case 4: return &cpu.cr4;
+		default: panic("cr%d is not implemented", n);
+	}
+}
+
+/* The r/m field always selects a general register. */
+make_helper(mov_cr2r) {
+	ModR_M m;
+	m.val = instr_fetch(eip + 1, 1);
+	reg_l(m.R_M) = *control_reg(m.reg);
+
+	print_asm("movl %%cr%d,%%%s", m.reg, regsl[m.R_M]);
+	return 2;
+}
+
+make_helper(mov_r2cr) {
+	ModR_M m;
+	m.val = instr_fetch(eip + 1, 1);
+	*control_reg(m.reg) = reg_l(m.R_M);
+	if(m.reg != 2) {
+		/* the page directory or the way it is used may have changed */
+		page_flush();
+	}
+
+	print_asm("movl %%%s,%%cr%d", regsl[m.R_M], m.reg);
+	return 2;
+}
+
+make_helper(int_i) {
+	uint8_t NO = instr_fetch(eip + 1, 1);
+	print_asm("int $0x%x", NO);
+
+#ifdef DIRECT_BOOT
+	if(NO == 0x80 && cpu.idtr.limit == 0) {
+		void boot_syscall();
+		boot_syscall();
+		return 2;
+	}
+#endif
+
+	/* return to the next instruction */
+	cpu.eip += 2;
+	raise_intr(NO);
+	return 0;
+}
+
+make_helper(iret) {
+	return_from_intr();
+	print_asm("iret");
+	return 0;
+}
+
+make_helper(cli) {
+	cpu.IF = 0;
+	print_asm("cli");
+	return 1;
+}
+
+make_helper(sti) {
+	cpu.IF = 1;
+	intr_check();
+	print_asm("sti");
+	return 1;
+}
+
+/* Stop until an interrupt is taken. The CPU loop then moves the time
+ * from one deadline to the next instead of executing instructions, so
+ * the idle time retires no instruction (see cpu-exec.c).
+ */
+make_helper(hlt) {
+	Assert(cpu.IF, "hlt at eip = 0x%08x would never wake up", eip);
+	cpu.halted = true;
+	event_kick();
+
+	print_asm("hlt");
+	return 1;
+}
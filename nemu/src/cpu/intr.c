@@ -0,0 +1,95 @@
+#include "nemu.h"
+#include "device/event.h"
+#include "device/i8259.h"
+#include "cpu/intr.h"
+#include <setjmp.h>
+
+extern jmp_buf jbuf;
+
+swaddr_t instr_eip;
+uint32_t instr_esp;
+
+#define GATE_INTR 0xe
+#define GATE_TRAP 0xf
+
+static inline void push_l(uint32_t val) {
+	cpu.esp -= 4;
+	swaddr_write(cpu.esp, 4, val, R_SS);
+}
+
+static inline uint32_t pop_l() {
+	uint32_t val = swaddr_read(cpu.esp, 4, R_SS);
+	cpu.esp += 4;
+	return val;
+}
+
+/* Enter the handler of interrupt ``NO'' through its gate in the IDT.
+ * ``cpu.eip'' should point to the instruction to return to. There is
+ * only one privilege level, so the stack is never switched.
+ */
+void raise_intr(uint8_t NO) {
+	Assert(NO * 8 + 7 <= cpu.idtr.limit, "interrupt %d is beyond the IDT limit 0x%x", NO, cpu.idtr.limit);
+
+	lnaddr_t gate = cpu.idtr.base + NO * 8;
+	uint32_t lo = lnaddr_read(gate, 4);
+	uint32_t hi = lnaddr_read(gate + 4, 4);
+	int type = (hi >> 8) & 0xf;
+	Assert(hi & 0x8000, "the gate of interrupt %d is not present", NO);
+	Assert(type == GATE_INTR || type == GATE_TRAP, "the gate of interrupt %d has type 0x%x", NO, type);
+
+	push_l(cpu.eflags);
+	push_l(cpu.sreg[R_CS].val);
+	push_l(cpu.eip);
+
+	if(type == GATE_INTR) {
+		cpu.IF = 0;
+	}
+	cpu.TF = 0;
+	load_sreg(R_CS, lo >> 16);
+	cpu.eip = (hi & 0xffff0000) | (lo & 0xffff);
+}
+
+/* Raise an exception with an error code while executing an instruction,
+ * which is restarted after the handler returns.
+ */
+void raise_exception(uint8_t NO, uint32_t error_code) {
+	static bool in_exception = false;
+	Assert(!in_exception, "exception %d while raising an exception at eip = 0x%08x", NO, instr_eip);
+
+	cpu.eip = instr_eip;
+	cpu.esp = instr_esp;
+	in_exception = true;
+	raise_intr(NO);
+	push_l(error_code);
+	in_exception = false;
+
+	/* abandon the instruction */
+	longjmp(jbuf, 1);
+}
+
+/* Return from an interrupt handler. */
+void return_from_intr() {
+	cpu.eip = pop_l();
+	load_sreg(R_CS, pop_l());
+	cpu.eflags = pop_l() | 0x2;
+	intr_check();
+}
+
+/* Called whenever IF may have been set: the CPU loop takes a pending
+ * interrupt only after being kicked.
+ */
+void intr_check() {
+	if(cpu.INTR && cpu.IF) {
+		event_kick();
+	}
+}
+
+/* Take the pending interrupt of the i8259 if it is deliverable. */
+void intr_deliver() {
+	if(cpu.INTR && cpu.IF) {
+		uint8_t NO = i8259_query_intr();
+		i8259_ack_intr();
+		raise_intr(NO);
+		cpu.halted = false;
+	}
+}
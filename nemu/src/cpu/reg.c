@@ -1,4 +1,5 @@
 #include "nemu.h"
+#include "cpu/intr.h"
 #include <stdlib.h>
 #include <time.h>
 
@@ -7,6 +8,49 @@ CPU_state cpu;
 const char *regsl[] = {"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi"};
 const char *regsw[] = {"ax", "cx", "dx", "bx", "sp", "bp", "si", "di"};
 const char *regsb[] = {"al", "cl", "dl", "bl", "ah", "ch", "dh", "bh"};
+const char *regss[] = {"es", "cs", "ss", "ds"};
+
+/* Load the selector ``val'' into the segment register ``sreg'' with its
+ * descriptor in the GDT. NEMU has no real mode: before protection is
+ * enabled, every segment is flat. A selector beyond the GDT limit raises
+ * #GP, and a segment not present raises #NP (#SS for the stack), with the selector as the
+ * error code. A null selector leaves the data segment unusable.
+ */
+void load_sreg(int sreg, uint16_t val) {
+	SegReg *s = &cpu.sreg[sreg];
+	if(!(cpu.cr0 & CR0_PE)) {
+		s->val = val;
+		s->base = 0;
+		s->limit = 0xffffffff;
+		s->usable = true;
+	}
+	else {
+		uint32_t index = val >> 3;
+		if(index == 0) {
+			if(sreg == R_CS || sreg == R_SS) { raise_exception(13, 0); }
+			s->val = val;
+			s->base = s->limit = 0;
+			s->flat = s->usable = false;
+			return;
+		}
+		if(index * 8 + 7 > cpu.gdtr.limit) { raise_exception(13, val & 0xfffc); }
+
+		lnaddr_t desc = cpu.gdtr.base + index * 8;
+		uint32_t lo = lnaddr_read(desc, 4);
+		uint32_t hi = lnaddr_read(desc + 4, 4);
+		if(!(hi & 0x8000)) { raise_exception(sreg == R_SS ? 12 : 11, val & 0xfffc); }
+
+		s->val = val;
+		s->usable = true;
+		s->base = (lo >> 16) | ((hi & 0xff) << 16) | (hi & 0xff000000);
+		s->limit = (lo & 0xffff) | (hi & 0xf0000);
+		if(hi & 0x800000) {
+			/* the limit is in 4KB units */
+			s->limit = (s->limit << 12) | 0xfff;
+		}
+	}
+	s->flat = (s->base == 0 && s->limit == 0xffffffff);
+}
 
 void reg_test() {
 	srand(time(0));
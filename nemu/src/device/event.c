@@ -0,0 +1,123 @@
+#include "device/event.h"
+
+/* A hashed timer wheel. An event is linked into the slot of its time,
+ * and the slots cover WHEEL_GRAIN units of time each. Events more than
+ * one round ahead share the slots with nearer ones, so their full time
+ * is always compared.
+ */
+
+#define WHEEL_SHIFT 10
+#define WHEEL_GRAIN (1ull << WHEEL_SHIFT)
+#define NR_SLOT 256
+
+static Event *wheel[NR_SLOT];
+
+uint64_t event_deadline = ~0ull;
+#ifndef VIRTUAL_CLOCK
+uint64_t event_idle = 0;
+#endif
+/* the time of the nearest event, which ``event_deadline'' is never after */
+static uint64_t next_event = ~0ull;
+
+static inline Event **slot_of(uint64_t when) {
+	return &wheel[(when >> WHEEL_SHIFT) & (NR_SLOT - 1)];
+}
+
+/* Find the nearest event. ``event_deadline'' is left alone, since it
+ * may hold the other deadlines of the CPU loop; it is early at worst,
+ * which is taken as a kick.
+ */
+static void find_next_event() {
+	uint64_t slot = event_now() >> WHEEL_SHIFT;
+	int i;
+	next_event = ~0ull;
+	for(i = 0; i < NR_SLOT; i ++, slot ++) {
+		Event *ev;
+		for(ev = wheel[slot & (NR_SLOT - 1)]; ev; ev = ev->next) {
+			if(ev->when < next_event) { next_event = ev->when; }
+		}
+		/* the nearest event is in this round of the wheel */
+		if(next_event < (slot + 1) * WHEEL_GRAIN) { break; }
+	}
+}
+
+void event_add(Event *ev, uint64_t delay) {
+	if(ev->pending) {
+		event_del(ev);
+	}
+
+	Event **slot = slot_of(event_now() + delay);
+	ev->when = event_now() + delay;
+	ev->next = *slot;
+	ev->pending = true;
+	*slot = ev;
+
+	if(ev->when < next_event) {
+		next_event = ev->when;
+	}
+	if(ev->when < event_deadline) {
+		event_deadline = ev->when;
+	}
+}
+
+void event_del(Event *ev) {
+	if(!ev->pending) {
+		return;
+	}
+
+	Event **p;
+	for(p = slot_of(ev->when); *p != ev; p = &(*p)->next) {
+		assert(*p != NULL);
+	}
+	*p = ev->next;
+	ev->pending = false;
+
+	if(ev->when == next_event) {
+		find_next_event();
+	}
+}
+
+/* Called by the CPU loop when ``event_now()'' reaches ``event_deadline''. */
+void event_dispatch() {
+	uint64_t now = event_now();
+	event_deadline = next_event;
+	if(now < next_event) {
+		/* only kicked */
+		return;
+	}
+
+	uint64_t slot = next_event >> WHEEL_SHIFT;
+	uint64_t last = now >> WHEEL_SHIFT;
+	Event *due = NULL;
+
+	if(last - slot >= NR_SLOT) {
+		/* all slots are due */
+		slot = last - NR_SLOT + 1;
+	}
+
+	/* Unlink the due events first, since handlers may add events. */
+	for(; slot <= last; slot ++) {
+		Event **p = &wheel[slot & (NR_SLOT - 1)];
+		while(*p != NULL) {
+			Event *ev = *p;
+			if(ev->when <= now) {
+				*p = ev->next;
+				ev->pending = false;
+				ev->next = due;
+				due = ev;
+			}
+			else {
+				p = &ev->next;
+			}
+		}
+	}
+
+	find_next_event();
+	event_deadline = next_event;
+
+	while(due != NULL) {
+		Event *ev = due;
+		due = ev->next;
+		ev->handler();
+	}
+}
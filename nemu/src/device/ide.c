@@ -2,6 +2,8 @@
 #include "memory/memory.h"
 #include "device/port-io.h"
 #include "device/i8259.h"
+#include "device/replay.h"
+#include "device/event.h"
 
 #define IDE_CTRL_PORT 0x3F6
 #define IDE_PORT 0x1F0
@@ -9,16 +11,47 @@
 
 #define IDE_IRQ 14
 
+/* latencies in CPU cycles for the virtual clock */
+#define IDE_SEEK_CYCLES (CPU_HZ / 10000)
+#define IDE_BYTE_CYCLES 2
+
 static uint8_t *ide_port_base;
 static uint8_t *bmr_base;	/* bus master registers */
 
 static uint32_t sector, disk_idx;
-static uint32_t byte_cnt;
+static uint32_t byte_cnt, nr_byte;
 static bool ide_write;
 static FILE *disk_fp;
 
+/* Finish a read command and raise the interrupt. */
+static void ide_complete() {
+	ide_port_base[7] = 0x40;
+	device_sync_event(EV_IDE, sector);
+	i8259_raise_intr(IDE_IRQ);
+}
+
+#ifdef VIRTUAL_CLOCK
+static Event ide_event = { .handler = ide_complete };
+#endif
+
+static void ide_issue(uint32_t nbyte) {
+#ifdef VIRTUAL_CLOCK
+	/* busy until the data arrive */
+	ide_port_base[7] = 0x80;
+	event_add(&ide_event, IDE_SEEK_CYCLES + nbyte * IDE_BYTE_CYCLES);
+#else
+	ide_complete();
+#endif
+}
+
+/* Reads beyond the end of the disk image give zeros. */
+static void disk_read(void *buf, size_t len) {
+	size_t ret = fread(buf, 1, len, disk_fp);
+	memset(buf + ret, 0, len - ret);
+}
+
 void ide_io_handler(ioaddr_t addr, size_t len, bool is_write) {
-	assert(byte_cnt <= 512);
+	assert(byte_cnt <= nr_byte);
 	int ret;
 	if(is_write) {
 		if(addr - IDE_PORT == 0 && len == 4) {
@@ -28,7 +61,7 @@ void ide_io_handler(ioaddr_t addr, size_t len, bool is_write) {
 			assert(ret == 1);
 
 			byte_cnt += 4;
-			if(byte_cnt == 512) {
+			if(byte_cnt == nr_byte) {
 				/* finish */
 				ide_port_base[7] = 0x40;
 			}
@@ -41,15 +74,15 @@ void ide_io_handler(ioaddr_t addr, size_t len, bool is_write) {
 				disk_idx = sector << 9;
 				fseek(disk_fp, disk_idx, SEEK_SET);
 
+				/* the sector count register, where 0 means 256 sectors */
+				nr_byte = (ide_port_base[2] == 0 ? 256 : ide_port_base[2]) << 9;
 				byte_cnt = 0;
 
 				if(ide_port_base[7] == 0x20) {
 					/* command: read from disk */
 					ide_write = false;
-					ret = fread(ide_port_base, 4, 1, disk_fp);
-					assert(ret == 1);
-					ide_port_base[7] = 0x40;
-					i8259_raise_intr(IDE_IRQ);
+					disk_read(ide_port_base, 4);
+					ide_issue(nr_byte);
 				}
 				else {
 					/* command: write to disk */
@@ -72,20 +105,15 @@ void ide_io_handler(ioaddr_t addr, size_t len, bool is_write) {
 		if(addr - IDE_PORT == 0 && len == 4) {
 			/* read 4 bytes data from disk */
 			assert(!ide_write);
-			ret = fread(ide_port_base, 4, 1, disk_fp);
-			assert(ret == 1);
-
 			byte_cnt += 4;
-			if(byte_cnt == 512) {
-				/* finish */
-				ide_port_base[7] = 0x40;
+			if(byte_cnt < nr_byte) {
+				disk_read(ide_port_base, 4);
 			}
 		}
 	}
 }
 
 void bmr_io_handler(ioaddr_t addr, size_t len, bool is_write) {
-	int ret;
 	if(is_write) {
 		if(addr - BMR_PORT == 0) {
 			if(bmr_base[0] & 0x1) {
@@ -105,15 +133,13 @@ void bmr_io_handler(ioaddr_t addr, size_t len, bool is_write) {
 					disk_idx = sector << 9;
 					fseek(disk_fp, disk_idx, SEEK_SET);
 
-					ret = fread((void *)hwa_to_va(addr), byte_cnt, 1, disk_fp);
-					assert(ret == 1);
+					disk_read((void *)hwa_to_va(addr), byte_cnt);
 
 					/* We only implement PRDT of single entry. */
 					assert(hi_entry & 0x80000000);
 
 					/* finish */
-					ide_port_base[7] = 0x40;
-					i8259_raise_intr(IDE_IRQ);
+					ide_issue(byte_cnt);
 				}
 				else {
 					/* DMA write is not implemented */
@@ -1,6 +1,7 @@
 #include "common.h"
 #include "device/mmio.h"
 #include "misc.h"
+#include "monitor/reverse.h"
 
 #define MMIO_SPACE_MAX (256 * 1024)
 #define NR_MAP 8
@@ -49,6 +50,7 @@ uint32_t mmio_read(hwaddr_t addr, size_t len, int map_NO) {
 	MMIO_t *map = &maps[map_NO];
 	uint32_t data = *(uint32_t *)(map->mmio_space + (addr - map->low)) 
 		& (~0u >> ((4 - len) << 3));
+	rev_device_access();
 	map->callback(addr, len, false);
 	return data;
 }
@@ -58,5 +60,6 @@ void mmio_write(hwaddr_t addr, size_t len, uint32_t data, int map_NO) {
 	MMIO_t *map = &maps[map_NO];
 	uint32_t mask = (~0u >> ((4 - len) << 3));
 	memcpy_with_mask(map->mmio_space + (addr - map->low), &data, len, (void *)&mask);
+	rev_device_access();
 	maps[map_NO].callback(addr, len, true);
 }
@@ -1,5 +1,6 @@
 #include "common.h"
 #include "device/port-io.h"
+#include "monitor/reverse.h"
 
 #define PORT_IO_SPACE_MAX 65536
 #define NR_MAP 8
@@ -20,6 +21,7 @@ static void pio_callback(ioaddr_t addr, size_t len, bool is_write) {
 	int i;
 	for(i = 0; i < nr_map; i ++) {
 		if(addr >= maps[i].low && addr + len - 1 <= maps[i].high) {
+			rev_device_access();
 			maps[i].callback(addr, len, is_write);
 			return;
 		}
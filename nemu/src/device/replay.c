@@ -0,0 +1,271 @@
+#include "nemu.h"
+#include "device/replay.h"
+#include "device/event.h"
+#include "monitor/monitor.h"
+#include "monitor/reverse.h"
+
+#include <stdlib.h>
+
+/* Record and replay of device inputs.
+ *
+ * Asynchronous events (timer ticks and key strokes) come from the
+ * timer in sdl.c, which depends on the host time. In record mode they
+ * are queued and delivered by the CPU loop at the next instruction
+ * boundary, and the number of retired
+ * instructions is logged with each of them. In replay mode the host
+ * events are dropped, and the logged ones are delivered at exactly the
+ * same instruction counts.
+ *
+ * Synchronous events (IDE completion) are raised by the guest's own
+ * port I/O, so they are deterministic already. They are logged as well,
+ * and checked during replay to detect a diverged execution.
+ *
+ * For reverse execution, asynchronous events can also be kept in an
+ * in-memory journal. After the machine is rolled back to a checkpoint,
+ * the journaled events are delivered again until the execution reaches
+ * the point where the rollback happened.
+ */
+
+typedef struct {
+	uint64_t count;
+	uint32_t type;
+	uint32_t data;
+} ReplayEvent;
+
+#define REPLAY_MAGIC 0x4c50524e		/* "NRPL" */
+
+typedef struct {
+	uint32_t magic;
+	uint32_t pad;
+	uint64_t start_count;
+} ReplayHeader;
+
+void timer_intr();
+void keyboard_intr(uint8_t);
+
+int replay_mode = REPLAY_OFF;
+uint64_t replay_deadline = ~0ull;
+
+static FILE *replay_fp;
+
+/* events queued from the host in record mode */
+#define NR_QUEUE 64
+static ReplayEvent queue[NR_QUEUE];
+static int q_head, q_tail;
+
+/* the next logged event in replay mode */
+static ReplayEvent next_ev;
+static bool has_next_ev;
+
+/* the journal for reverse execution */
+bool journal_on = false;
+static ReplayEvent *journal;
+static int journal_len, journal_cap, journal_pos;
+/* journaled events are re-delivered until this instruction count */
+static uint64_t journal_end;
+
+static void deliver(int type, uint32_t data) {
+	switch(type) {
+		case EV_TIMER: timer_intr(); break;
+		case EV_KEYBOARD: keyboard_intr(data); break;
+		default: assert(0);
+	}
+}
+
+static void read_next_ev() {
+	has_next_ev = (fread(&next_ev, sizeof(next_ev), 1, replay_fp) == 1);
+	replay_deadline = has_next_ev ? next_ev.count : ~0ull;
+}
+
+static void replay_diverge(const char *why) {
+	printf("replay diverged at instruction %llu: %s\n",
+			(unsigned long long)cpu.instr_cnt, why);
+	replay_stop();
+}
+
+bool replay_start(int mode, const char *filename) {
+	replay_stop();
+	if(journal_on) {
+		printf("Can not record or replay during reverse execution\n");
+		return false;
+	}
+
+	ReplayHeader h;
+	if(mode == REPLAY_RECORD) {
+		replay_fp = fopen(filename, "wb");
+		if(replay_fp == NULL) { return false; }
+		h.magic = REPLAY_MAGIC;
+		h.pad = 0;
+		h.start_count = cpu.instr_cnt;
+		int ret = fwrite(&h, sizeof(h), 1, replay_fp);
+		assert(ret == 1);
+		q_head = q_tail = 0;
+		replay_deadline = ~0ull;
+	}
+	else {
+		replay_fp = fopen(filename, "rb");
+		if(replay_fp == NULL) { return false; }
+		if(fread(&h, sizeof(h), 1, replay_fp) != 1 || h.magic != REPLAY_MAGIC) {
+			printf("'%s' is not a replay log\n", filename);
+			fclose(replay_fp);
+			return false;
+		}
+		if(h.start_count != cpu.instr_cnt) {
+			printf("the log is recorded from instruction %llu, but %llu instructions have been executed\n",
+					(unsigned long long)h.start_count, (unsigned long long)cpu.instr_cnt);
+			fclose(replay_fp);
+			return false;
+		}
+		read_next_ev();
+	}
+
+	replay_mode = mode;
+	return true;
+}
+
+void replay_stop() {
+	if(replay_mode == REPLAY_OFF) {
+		return;
+	}
+
+	replay_mode = REPLAY_OFF;
+	replay_deadline = ~0ull;
+	fclose(replay_fp);
+	replay_fp = NULL;
+}
+
+static void log_event(int type, uint32_t data) {
+	ReplayEvent ev;
+	ev.count = cpu.instr_cnt;
+	ev.type = type;
+	ev.data = data;
+	int ret = fwrite(&ev, sizeof(ev), 1, replay_fp);
+	assert(ret == 1);
+}
+
+static void journal_append(int type, uint32_t data) {
+	if(journal_len == journal_cap) {
+		journal_cap = (journal_cap == 0 ? 256 : journal_cap * 2);
+		journal = realloc(journal, journal_cap * sizeof(journal[0]));
+		assert(journal);
+	}
+	journal[journal_len].count = cpu.instr_cnt;
+	journal[journal_len].type = type;
+	journal[journal_len].data = data;
+	journal_len ++;
+}
+
+static inline bool journal_replaying() {
+	return journal_on && cpu.instr_cnt < journal_end;
+}
+
+void journal_start() {
+	journal_len = journal_pos = 0;
+	journal_end = 0;
+	q_head = q_tail = 0;
+	journal_on = true;
+}
+
+void journal_stop() {
+	journal_on = false;
+	free(journal);
+	journal = NULL;
+	journal_len = journal_cap = journal_pos = 0;
+	replay_deadline = ~0ull;
+}
+
+/* Forget the events before instruction ``count''. */
+void journal_trim(uint64_t count) {
+	int i;
+	for(i = 0; i < journal_len && journal[i].count < count; i ++);
+	memmove(journal, journal + i, (journal_len - i) * sizeof(journal[0]));
+	journal_len -= i;
+	journal_pos = (journal_pos > i ? journal_pos - i : 0);
+}
+
+/* The machine has been rolled back to instruction ``cpu.instr_cnt''
+ * from instruction ``present''. */
+void journal_rewind(uint64_t present) {
+	if(present > journal_end) { journal_end = present; }
+	for(journal_pos = 0; journal_pos < journal_len &&
+			journal[journal_pos].count < cpu.instr_cnt; journal_pos ++);
+	q_head = q_tail = 0;
+	replay_deadline = 0;
+}
+
+/* Called by the CPU loop at an instruction boundary
+ * when ``cpu.instr_cnt'' reaches ``replay_deadline''.
+ */
+void replay_dispatch() {
+	if(journal_replaying()) {
+		while(journal_pos < journal_len && journal[journal_pos].count == cpu.instr_cnt) {
+			deliver(journal[journal_pos].type, journal[journal_pos].data);
+			journal_pos ++;
+		}
+		replay_deadline = (journal_pos < journal_len ? journal[journal_pos].count : journal_end);
+	}
+	else if(replay_mode == REPLAY_RECORD || journal_on) {
+		if(journal_on && journal_pos < journal_len) {
+			/* back at the present, the journal of the old future is dropped */
+			journal_len = journal_pos;
+		}
+		replay_deadline = ~0ull;
+		while(q_tail != q_head) {
+			ReplayEvent *ev = &queue[q_tail];
+			if(journal_on) { journal_append(ev->type, ev->data); journal_pos = journal_len; }
+			else { log_event(ev->type, ev->data); }
+			deliver(ev->type, ev->data);
+			q_tail = (q_tail + 1) % NR_QUEUE;
+		}
+	}
+	else if(replay_mode == REPLAY_PLAY) {
+		while(has_next_ev && next_ev.count == cpu.instr_cnt && next_ev.type != EV_IDE) {
+			deliver(next_ev.type, next_ev.data);
+			read_next_ev();
+		}
+		if(has_next_ev && next_ev.count < cpu.instr_cnt) {
+			replay_diverge("an IDE request in the log is never issued");
+		}
+	}
+}
+
+/* Called by devices when an asynchronous event comes from the host. */
+void device_event(int type, uint32_t data) {
+	if(journal_replaying()) {
+		/* the events are coming from the journal */
+		return;
+	}
+
+	if(replay_mode == REPLAY_OFF && !journal_on) {
+		deliver(type, data);
+	}
+	else if(replay_mode == REPLAY_RECORD || journal_on) {
+		/* Events are only accepted when the guest is running, as
+		 * timer_intr() and keyboard_intr() do. */
+		int next = (q_head + 1) % NR_QUEUE;
+		if(nemu_state == RUNNING && next != q_tail) {
+			queue[q_head].type = type;
+			queue[q_head].data = data;
+			q_head = next;
+			replay_deadline = 0;
+			event_kick();
+		}
+	}
+	/* In replay mode the events from the host are dropped. */
+}
+
+/* Called by devices when an event is caused by the guest itself. */
+void device_sync_event(int type, uint32_t data) {
+	rev_device_access();
+	if(replay_mode == REPLAY_RECORD) {
+		log_event(type, data);
+	}
+	else if(replay_mode == REPLAY_PLAY) {
+		if(!has_next_ev || next_ev.count != cpu.instr_cnt
+				|| next_ev.type != type || next_ev.data != data) {
+			replay_diverge("unexpected IDE request");
+			return;
+		}
+		read_next_ev();
+	}
+}
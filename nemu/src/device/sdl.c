@@ -4,9 +4,10 @@
 
 #include "sdl.h"
 #include "vga.h"
+#include "device/replay.h"
+#include "device/event.h"
 
-#include <sys/time.h>
-#include <signal.h>
+#include <time.h>
 
 extern uint8_t fontdata_8x16[128][16];
 SDL_Surface *real_screen;
@@ -15,14 +16,25 @@ uint8_t (*pixel_buf) [SCREEN_COL];
 
 #define TIMER_HZ 100
 
+#ifdef VIRTUAL_CLOCK
+#define TIMER_PERIOD (CPU_HZ / TIMER_HZ)
+#else
+/* Without the virtual clock, the timer follows the CPU time of NEMU
+ * as ITIMER_VIRTUAL did. The host clock is checked every TIMER_PERIOD
+ * instructions. */
+#define TIMER_PERIOD 10000
+#endif
+
 static uint64_t jiffy = 0;
-static struct itimerval it;
-extern void timer_intr();
-extern void keyboard_intr();
+static Event timer_event;
+#ifndef VIRTUAL_CLOCK
+static double next_tick;
+#endif
 extern void update_screen();
-static void device_update(int signum) {
+
+static void device_update() {
 	jiffy ++;
-	timer_intr();
+	device_event(EV_TIMER, 0);
 	if(jiffy % (TIMER_HZ / VGA_HZ) == 0) {
 		update_screen();
 	}
@@ -33,10 +45,10 @@ static void device_update(int signum) {
 
 		uint32_t sym = event.key.keysym.sym;
 		if( event.type == SDL_KEYDOWN ) {
-			keyboard_intr(sym2scancode[sym >> 8][sym & 0xff]);
+			device_event(EV_KEYBOARD, sym2scancode[sym >> 8][sym & 0xff]);
 		}
 		else if( event.type == SDL_KEYUP ) {
-			keyboard_intr(sym2scancode[sym >> 8][sym & 0xff] | 0x80);
+			device_event(EV_KEYBOARD, sym2scancode[sym >> 8][sym & 0xff] | 0x80);
 		}
 
 		// If the user has Xed out the window
@@ -45,9 +57,34 @@ static void device_update(int signum) {
 			exit(0);
 		}
 	}
+}
+
+#ifndef VIRTUAL_CLOCK
+static double host_cpu_time() {
+	struct timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+#endif
+
+static void timer_handler() {
+#ifdef VIRTUAL_CLOCK
+	device_update();
+#else
+	double now = host_cpu_time();
+	if(now >= next_tick) {
+		next_tick = now + 1.0 / TIMER_HZ;
+		device_update();
+	}
+#endif
+	event_add(&timer_event, TIMER_PERIOD);
+}
 
-	int ret = setitimer(ITIMER_VIRTUAL, &it, NULL);
-	Assert(ret == 0, "Can not set timer");
+/* Called in a new snapshot, whose CPU time starts over. */
+void restart_device_timer() {
+#ifndef VIRTUAL_CLOCK
+	next_tick = host_cpu_time() + 1.0 / TIMER_HZ;
+#endif
 }
 
 void sdl_clear_event_queue() {
@@ -74,15 +111,8 @@ void init_sdl() {
 
 	SDL_EnableKeyRepeat(SDL_DEFAULT_REPEAT_DELAY, SDL_DEFAULT_REPEAT_INTERVAL);
 
-	struct sigaction s;
-	memset(&s, 0, sizeof(s));
-	s.sa_handler = device_update;
-	ret = sigaction(SIGVTALRM, &s, NULL);
-	Assert(ret == 0, "Can not set signal handler");
-
-	it.it_value.tv_sec = 0;
-	it.it_value.tv_usec = 1000000 / TIMER_HZ;
-	ret = setitimer(ITIMER_VIRTUAL, &it, NULL);
-	Assert(ret == 0, "Can not set timer");
+	timer_event.handler = timer_handler;
+	restart_device_timer();
+	event_add(&timer_event, TIMER_PERIOD);
 }
 #endif	/* HAS_DEVICE */
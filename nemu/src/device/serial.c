@@ -1,29 +1,208 @@
 #include "common.h"
+#include "memory/memory.h"
 #include "device/port-io.h"
+#include "device/i8259.h"
+#include "device/event.h"
+
+#include <pthread.h>
 
 /* http://en.wikibooks.org/wiki/Serial_Programming/8250_UART_Programming */
 
+/* A 16550 with only the transmitter. The bytes written go to a FIFO,
+ * which is sent when it is full or shortly after the first byte, and
+ * then raises the THRE interrupt if it is enabled. Since a full FIFO is
+ * sent at once, it never overruns.
+ *
+ * Sent bytes are put into a host ring, which is written to stdout by a
+ * writer thread, so the CPU loop never waits for the host I/O unless
+ * the ring is full.
+ *
+ * The fast console is a paravirtual port for a whole buffer: ``out'' the
+ * physical address of a descriptor {physical address, length} to it.
+ * Reading it gives CONSOLE_MAGIC before anything is written.
+ */
+
 #define SERIAL_PORT 0x3F8
+#define SERIAL_IRQ 4
 #define CH_OFFSET 0
+#define IER_OFFSET 1		/* interrupt enable register */
+#define IIR_OFFSET 2		/* interrupt identification register */
+#define LCR_OFFSET 3		/* line control register */
 #define LSR_OFFSET 5		/* line status register */
 
+#define IER_THRE 0x2
+#define IIR_NONE 0x1
+#define IIR_THRE 0x2
+#define LCR_DLAB 0x80
+#define LSR_THRE 0x20
+#define LSR_TEMT 0x40
+
+#define FIFO_SIZE 16
+/* the time from the first byte written to the FIFO being sent */
+#define FIFO_TIMEOUT 16
+
+#define CONSOLE_PORT 0x3E0
+#define CONSOLE_MAGIC 0x554d454e	/* "NEMU" */
+
+#define RING_SIZE (64 * 1024)
+
 static uint8_t *serial_port_base;
+static uint8_t *console_port_base;
+
+static uint8_t fifo[FIFO_SIZE];
+static int fifo_len;
+
+static char ring[RING_SIZE];
+static size_t ring_head, ring_len;
+
+static pthread_t writer;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t has_data = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t has_space = PTHREAD_COND_INITIALIZER;
+static bool writing;
+
+static void *serial_writer(void *arg) {
+	pthread_mutex_lock(&lock);
+	while(1) {
+		while(ring_len == 0) {
+			pthread_cond_wait(&has_data, &lock);
+		}
+
+		/* write the contiguous part, without holding the lock */
+		size_t tail = (ring_head + RING_SIZE - ring_len) % RING_SIZE;
+		size_t len = (tail + ring_len > RING_SIZE ? RING_SIZE - tail : ring_len);
+		writing = true;
+		pthread_mutex_unlock(&lock);
+		fwrite(ring + tail, 1, len, stdout);
+		fflush(stdout);
+		pthread_mutex_lock(&lock);
+
+		ring_len -= len;
+		writing = false;
+		pthread_cond_broadcast(&has_space);
+	}
+	return NULL;
+}
+
+static void ring_write(const void *buf, size_t len) {
+	pthread_mutex_lock(&lock);
+	while(len > 0) {
+		while(ring_len == RING_SIZE) {
+			pthread_cond_wait(&has_space, &lock);
+		}
+		size_t n = RING_SIZE - ring_len;
+		if(n > RING_SIZE - ring_head) { n = RING_SIZE - ring_head; }
+		if(n > len) { n = len; }
+		memcpy(ring + ring_head, buf, n);
+		ring_head = (ring_head + n) % RING_SIZE;
+		ring_len += n;
+		buf += n;
+		len -= n;
+		pthread_cond_signal(&has_data);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+/* Wait until everything sent is on stdout, before NEMU prints anything. */
+void serial_flush() {
+	pthread_mutex_lock(&lock);
+	while(ring_len > 0 || writing) {
+		pthread_cond_wait(&has_space, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+static void fifo_send() {
+	ring_write(fifo, fifo_len);
+	fifo_len = 0;
+	serial_port_base[LSR_OFFSET] = LSR_THRE | LSR_TEMT;
+	if(serial_port_base[IER_OFFSET] & IER_THRE) {
+		serial_port_base[IIR_OFFSET] = IIR_THRE;
+		i8259_raise_intr(SERIAL_IRQ);
+	}
+}
+
+static Event fifo_event = { .handler = fifo_send };
 
 void serial_io_handler(ioaddr_t addr, size_t len, bool is_write) {
+	bool dlab = serial_port_base[LCR_OFFSET] & LCR_DLAB;
 	if(is_write) {
 		assert(len == 1);
-		if(addr == SERIAL_PORT + CH_OFFSET) {
-			char c = serial_port_base[CH_OFFSET];
-			/* We bind the serial port with the host stdout in NEMU. */
-			putc(c, stdout);
-			if(c == '\n') {
-				fflush(stdout);
+		if(addr == SERIAL_PORT + CH_OFFSET && !dlab) {
+			fifo[fifo_len ++] = serial_port_base[CH_OFFSET];
+			serial_port_base[LSR_OFFSET] = 0;
+			if(fifo_len == FIFO_SIZE) {
+				event_del(&fifo_event);
+				fifo_send();
+			}
+			else if(!fifo_event.pending) {
+				event_add(&fifo_event, FIFO_TIMEOUT);
 			}
 		}
+		else if(addr == SERIAL_PORT + IER_OFFSET && !dlab &&
+				(serial_port_base[IER_OFFSET] & IER_THRE) && fifo_len == 0) {
+			/* enabling the THRE interrupt with an empty FIFO raises it */
+			serial_port_base[IIR_OFFSET] = IIR_THRE;
+			i8259_raise_intr(SERIAL_IRQ);
+		}
+		else if(addr == SERIAL_PORT + IIR_OFFSET) {
+			/* the FIFO control register, which reads as the IIR */
+			serial_port_base[IIR_OFFSET] = IIR_NONE;
+		}
+	}
+	else if(addr == SERIAL_PORT + IIR_OFFSET) {
+		/* reading the IIR clears the THRE interrupt */
+		serial_port_base[IIR_OFFSET] = IIR_NONE;
 	}
 }
 
+/* the console writes dropped for a descriptor or a buffer out of the DRAM */
+static uint32_t console_nr_drop;
+
+void console_io_handler(ioaddr_t addr, size_t len, bool is_write) {
+	if(is_write) {
+		assert(len == 4);
+		hwaddr_t desc = *(uint32_t *)console_port_base;
+		hwaddr_t buf = 0;
+		uint32_t buf_len = 0;
+		bool valid = desc <= HW_MEM_SIZE - 8;
+		if(valid) {
+			buf = hwaddr_read(desc, 4);
+			buf_len = hwaddr_read(desc + 4, 4);
+			valid = buf < HW_MEM_SIZE && buf_len <= HW_MEM_SIZE - buf;
+		}
+
+		/* The descriptor comes from the guest, so a bad one is only
+		 * dropped. Only the first one is logged.
+		 */
+		if(!valid) {
+			if(console_nr_drop ++ == 0) {
+				Log("console descriptor 0x%08x with buffer [0x%08x, +0x%x) is dropped",
+						desc, buf, buf_len);
+			}
+			return;
+		}
+		ring_write(hwa_to_va(buf), buf_len);
+	}
+}
+
+/* The writer thread does not survive fork(). */
+void restart_serial_writer() {
+	pthread_mutex_init(&lock, NULL);
+	pthread_cond_init(&has_data, NULL);
+	pthread_cond_init(&has_space, NULL);
+	writing = false;
+	int ret = pthread_create(&writer, NULL, serial_writer, NULL);
+	Assert(ret == 0, "Can not create the serial writer thread");
+}
+
 void init_serial() {
 	serial_port_base = add_pio_map(SERIAL_PORT, 8, serial_io_handler);
-	serial_port_base[LSR_OFFSET] = 0x20; /* the status is always free */
+	serial_port_base[LSR_OFFSET] = LSR_THRE | LSR_TEMT;
+	serial_port_base[IIR_OFFSET] = IIR_NONE;
+
+	console_port_base = add_pio_map(CONSOLE_PORT, 4, console_io_handler);
+	*(uint32_t *)console_port_base = CONSOLE_MAGIC;
+
+	restart_serial_writer();
 }
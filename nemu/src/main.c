@@ -1,7 +1,13 @@
+#include "common.h"
+
 void init_monitor(int, char *[]);
 void reg_test();
 void restart();
 void ui_mainloop();
+#ifdef HAS_DEVICE
+void init_device();
+void init_sdl();
+#endif
 
 int main(int argc, char *argv[]) {
 
@@ -11,6 +17,12 @@ int main(int argc, char *argv[]) {
 	/* Test the implementation of the ``CPU_state'' structure. */
 	reg_test();
 
+#ifdef HAS_DEVICE
+	/* Initialize the devices, the screen and the timer event. */
+	init_device();
+	init_sdl();
+#endif
+
 	/* Initialize the virtual computer system. */
 	restart();
 
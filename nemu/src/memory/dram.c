@@ -1,6 +1,7 @@
 #include "common.h"
 #include "burst.h"
 #include "misc.h"
+#include "cpu/clock.h"
 
 /* Simulate the (main) behavor of DRAM.
  * Although this will lower the performace of NEMU, it makes
@@ -31,7 +32,12 @@ typedef union {
 
 #define HW_MEM_SIZE (1 << (COL_WIDTH + ROW_WIDTH + BANK_WIDTH + RANK_WIDTH))
 
-uint8_t dram[NR_RANK][NR_BANK][NR_ROW][NR_COL];
+/* latencies in CPU cycles for the virtual clock */
+#define ROW_HIT_CYCLES 2
+#define ROW_MISS_CYCLES 8
+
+/* page aligned, so that direct boot can map the program into it */
+uint8_t dram[NR_RANK][NR_BANK][NR_ROW][NR_COL] __attribute__((aligned(4096)));
 uint8_t *hw_mem = (void *)dram;
 
 typedef struct {
@@ -66,6 +72,10 @@ static void ddr3_read(hwaddr_t addr, void *data) {
 		memcpy(rowbufs[rank][bank].buf, dram[rank][bank][row], NR_COL);
 		rowbufs[rank][bank].row_idx = row;
 		rowbufs[rank][bank].valid = true;
+		clock_advance(ROW_MISS_CYCLES);
+	}
+	else {
+		clock_advance(ROW_HIT_CYCLES);
 	}
 
 	/* burst read */
@@ -87,6 +97,10 @@ static void ddr3_write(hwaddr_t addr, void *data, uint8_t *mask) {
 		memcpy(rowbufs[rank][bank].buf, dram[rank][bank][row], NR_COL);
 		rowbufs[rank][bank].row_idx = row;
 		rowbufs[rank][bank].valid = true;
+		clock_advance(ROW_MISS_CYCLES);
+	}
+	else {
+		clock_advance(ROW_HIT_CYCLES);
 	}
 
 	/* burst write */
@@ -126,3 +140,13 @@ void dram_write(hwaddr_t addr, size_t len, uint32_t data) {
 		ddr3_write(addr + BURST_LEN, temp + BURST_LEN, mask + BURST_LEN);
 	}
 }
+
+#ifdef VIRTUAL_CLOCK
+/* Charge the virtual clock for ``len'' bytes accessed behind the row
+ * buffers, such as by a hypercall: a row miss, and then a burst for
+ * every BURST_LEN bytes.
+ */
+void dram_charge_stream(size_t len) {
+	clock_advance(ROW_MISS_CYCLES + (len + BURST_LEN - 1) / BURST_LEN * ROW_HIT_CYCLES);
+}
+#endif
@@ -1,37 +1,294 @@
 #include "common.h"
+#include "memory/memory.h"
+#include "cpu/reg.h"
+#include "cpu/intr.h"
+#include "monitor/monitor.h"
+#include "monitor/trace.h"
+#include "monitor/reverse.h"
+#include "monitor/gdb.h"
 
 uint32_t dram_read(hwaddr_t, size_t);
 void dram_write(hwaddr_t, size_t, uint32_t);
 
+#ifdef USE_RAMDISK
+uint8_t *ramdisk = NULL;
+#endif
+
 /* Memory accessing interfaces */
 
 uint32_t hwaddr_read(hwaddr_t addr, size_t len) {
+#ifdef USE_RAMDISK
+	if(addr >= RAMDISK_BASE) {
+		uint32_t data = 0;
+		memcpy(&data, &ramdisk_rw(addr, uint8_t), len);
+		return data;
+	}
+#endif
 	return dram_read(addr, len) & (~0u >> ((4 - len) << 3));
 }
 
 void hwaddr_write(hwaddr_t addr, size_t len, uint32_t data) {
+	if(rev_on) {
+		rev_track_write(addr, len);
+	}
+#ifdef USE_RAMDISK
+	if(addr >= RAMDISK_BASE) {
+		memcpy(&ramdisk_rw(addr, uint8_t), &data, len);
+		return;
+	}
+#endif
 	dram_write(addr, len, data);
 }
 
+#define PAGE_SIZE 4096
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+#define PTE_P  0x1
+#define PTE_W  0x2
+#define PDE_PS 0x80
+
+/* The last PDE used. Like a TLB, it is only valid until CR3 is loaded
+ * again, and a not present PDE is never kept.
+ */
+static struct {
+	bool valid;
+	uint32_t dir;
+	uint32_t pde;
+} pde_cache;
+
+void page_flush() {
+	pde_cache.valid = false;
+}
+
+/* Raise #PF for ``addr''. Only the execution of instructions gets here,
+ * the monitor uses the debug accesses below.
+ */
+static void page_fault(lnaddr_t addr, bool is_write, bool present) {
+	Assert(nemu_state == RUNNING, "page fault at 0x%08x out of execution", addr);
+	cpu.cr2 = addr;
+	raise_exception(14, (present ? 0x1 : 0) | (is_write ? 0x2 : 0));
+}
+
+/* Walk the page tables for ``addr''. Return false if the page is not
+ * present, or if it can not be written; ``*present'' tells which.
+ * Read-only pages can always be written at CPL 0 unless CR0.WP is set,
+ * and never at CPL 3.
+ */
+static inline bool page_walk(lnaddr_t addr, bool is_write, hwaddr_t *hwaddr, bool *present) {
+	uint32_t pde;
+	bool wp = (cpu.cr0 & CR0_WP) || (cpu.sreg[R_CS].val & 0x3) == 3;
+	*present = false;
+	if(pde_cache.valid && pde_cache.dir == addr >> 22) {
+		pde = pde_cache.pde;
+	}
+	else {
+		pde = hwaddr_read((cpu.cr3 & ~PAGE_MASK) + (addr >> 22) * 4, 4);
+		if(!(pde & PTE_P)) {
+			return false;
+		}
+		pde_cache.valid = true;
+		pde_cache.dir = addr >> 22;
+		pde_cache.pde = pde;
+	}
+
+	if((pde & PDE_PS) && (cpu.cr4 & CR4_PSE)) {
+		/* a 4MB page */
+		*present = true;
+		if(is_write && !(pde & PTE_W) && wp) {
+			return false;
+		}
+		*hwaddr = (pde & 0xffc00000) | (addr & 0x3fffff);
+		return true;
+	}
+
+	uint32_t pte = hwaddr_read((pde & ~PAGE_MASK) + ((addr >> 12) & 0x3ff) * 4, 4);
+	if(!(pte & PTE_P)) {
+		return false;
+	}
+
+	*present = true;
+	if(is_write && !(pde & pte & PTE_W) && wp) {
+		return false;
+	}
+
+	*hwaddr = (pte & ~PAGE_MASK) | (addr & PAGE_MASK);
+	return true;
+}
+
+static hwaddr_t page_translate(lnaddr_t addr, bool is_write) {
+	hwaddr_t hwaddr = 0;
+	bool present;
+	if(!page_walk(addr, is_write, &hwaddr, &present)) {
+		page_fault(addr, is_write, present);
+	}
+	return hwaddr;
+}
+
 uint32_t lnaddr_read(lnaddr_t addr, size_t len) {
+	if(cpu.cr0 & CR0_PG) {
+		size_t in_page = PAGE_SIZE - (addr & PAGE_MASK);
+		if(len > in_page) {
+			/* split the access at the page boundary */
+			uint32_t lo = lnaddr_read(addr, in_page);
+			return lo | (lnaddr_read(addr + in_page, len - in_page) << (in_page << 3));
+		}
+		addr = page_translate(addr, false);
+	}
 	return hwaddr_read(addr, len);
 }
 
 void lnaddr_write(lnaddr_t addr, size_t len, uint32_t data) {
+	if(cpu.cr0 & CR0_PG) {
+		size_t in_page = PAGE_SIZE - (addr & PAGE_MASK);
+		if(len > in_page) {
+			lnaddr_write(addr, in_page, data);
+			lnaddr_write(addr + in_page, len - in_page, data >> (in_page << 3));
+			return;
+		}
+		addr = page_translate(addr, true);
+	}
 	hwaddr_write(addr, len, data);
 }
 
-uint32_t swaddr_read(swaddr_t addr, size_t len) {
+/* Check [addr, addr + len) against the limit of the segment ``sreg'',
+ * and put the linear address of ``addr'' into ``*lnaddr''. A flat
+ * segment, which is all this kernel sets up, skips the base and the
+ * limit check.
+ */
+static inline bool seg_check(swaddr_t addr, size_t len, uint8_t sreg, lnaddr_t *lnaddr) {
+	SegReg *s = &cpu.sreg[sreg];
+	if(s->flat) {
+		*lnaddr = addr;
+		return true;
+	}
+	if(!s->usable || addr > s->limit || len - 1 > s->limit - addr) {
+		return false;
+	}
+	*lnaddr = s->base + addr;
+	return true;
+}
+
+/* Translate ``addr'' in the segment ``sreg'' to a linear address, or
+ * raise #GP (#SS for the stack) beyond the limit.
+ */
+static inline lnaddr_t seg_translate(swaddr_t addr, size_t len, uint8_t sreg) {
+	lnaddr_t lnaddr = 0;
+	if(!seg_check(addr, len, sreg, &lnaddr)) {
+		Assert(nemu_state == RUNNING, "0x%08x is beyond the limit of %s", addr, regss[sreg]);
+		raise_exception(sreg == R_SS ? 12 : 13, 0);
+	}
+	return lnaddr;
+}
+
+uint32_t swaddr_read(swaddr_t addr, size_t len, uint8_t sreg) {
 #ifdef DEBUG
 	assert(len == 1 || len == 2 || len == 4);
 #endif
-	return lnaddr_read(addr, len);
+	return lnaddr_read(seg_translate(addr, len, sreg), len);
 }
 
-void swaddr_write(swaddr_t addr, size_t len, uint32_t data) {
+/* Translate ``addr'' in the segment ``sreg'' for the host to access at
+ * most ``*len'' bytes directly, e.g. for a hypercall. The access stops
+ * at a page boundary and at the limit of the segment, and ``*len'' is
+ * set to the number of bytes it covers. A fault is raised as for an
+ * ordinary access to ``addr''. The pages to write are recorded for
+ * reverse execution, but the caller should invalidate the row buffers
+ * of DRAM after writing.
+ */
+void *swaddr_host_ptr(swaddr_t addr, size_t *len, bool is_write, uint8_t sreg) {
+	SegReg *s = &cpu.sreg[sreg];
+	size_t n = PAGE_SIZE - (addr & PAGE_MASK);
+	if(!s->flat && addr <= s->limit && n > s->limit - addr + 1) {
+		n = s->limit - addr + 1;
+	}
+	if(n > *len) { n = *len; }
+
+	lnaddr_t lnaddr = seg_translate(addr, 1, sreg);
+	if(!s->flat) {
+		/* the page boundary is in the linear address space */
+		size_t in_page = PAGE_SIZE - (lnaddr & PAGE_MASK);
+		if(n > in_page) { n = in_page; }
+	}
+	hwaddr_t hwaddr = (cpu.cr0 & CR0_PG ? page_translate(lnaddr, is_write) : lnaddr);
+	*len = n;
+
+	if(is_write && gdb_watch_on) {
+		gdb_watch_write(addr, n);
+	}
+	if(is_write && rev_on) {
+		rev_track_write(hwaddr, n);
+	}
+#ifdef USE_RAMDISK
+	if(hwaddr >= RAMDISK_BASE) {
+		return &ramdisk_rw(hwaddr, uint8_t);
+	}
+#endif
+	Assert(hwaddr < HW_MEM_SIZE, "physical address(0x%08x) is out of bound", hwaddr);
+	return hwa_to_va(hwaddr);
+}
+
+void swaddr_write(swaddr_t addr, size_t len, uint32_t data, uint8_t sreg) {
 #ifdef DEBUG
 	assert(len == 1 || len == 2 || len == 4);
 #endif
-	lnaddr_write(addr, len, data);
+	lnaddr_t lnaddr = seg_translate(addr, len, sreg);
+	if(trace_mem_on) {
+		trace_mem_write(addr, len, data);
+	}
+	if(gdb_watch_on) {
+		gdb_watch_write(addr, len);
+	}
+	lnaddr_write(lnaddr, len, data);
+}
+
+
+/* Accesses of the monitor and the debugger. They never raise a fault in
+ * the program, but fail if a byte is beyond the limit of the segment,
+ * not mapped or not in the memory.
+ * Write protection is ignored, so that the debugger can patch the code.
+ */
+static bool debug_translate(swaddr_t addr, uint8_t sreg, hwaddr_t *hwaddr) {
+	lnaddr_t lnaddr;
+	bool present;
+	if(!seg_check(addr, 1, sreg, &lnaddr)) {
+		return false;
+	}
+	if(!(cpu.cr0 & CR0_PG)) {
+		*hwaddr = lnaddr;
+	}
+	else if(!page_walk(lnaddr, false, hwaddr, &present)) {
+		return false;
+	}
+#ifdef USE_RAMDISK
+	if(*hwaddr >= RAMDISK_BASE) {
+		return ramdisk != NULL && *hwaddr - RAMDISK_BASE < RAMDISK_MAX_SIZE;
+	}
+#endif
+	return *hwaddr < HW_MEM_SIZE;
+}
+
+bool swaddr_debug_read(swaddr_t addr, size_t len, uint8_t sreg, uint32_t *data) {
+	uint32_t val = 0;
+	int i;
+	for(i = len - 1; i >= 0; i --) {
+		hwaddr_t hwaddr;
+		if(!debug_translate(addr + i, sreg, &hwaddr)) { return false; }
+		val = (val << 8) | hwaddr_read(hwaddr, 1);
+	}
+	*data = val;
+	return true;
 }
 
+bool swaddr_debug_write(swaddr_t addr, size_t len, uint32_t data, uint8_t sreg) {
+	hwaddr_t hwaddr[4];
+	int i;
+	assert(len <= 4);
+	/* translate all the bytes first, so that a failed write changes nothing */
+	for(i = 0; i < len; i ++) {
+		if(!debug_translate(addr + i, sreg, &hwaddr[i])) { return false; }
+	}
+	for(i = 0; i < len; i ++, data >>= 8) {
+		hwaddr_write(hwaddr[i], 1, data & 0xff);
+	}
+	return true;
+}
@@ -0,0 +1,120 @@
+#include "nemu.h"
+
+#ifdef DIRECT_BOOT
+
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* Direct boot loads the program in NEMU and starts it without the kernel,
+ * so no guest time is spent on loading. Whole pages of the file image are
+ * mapped into the physical memory with mmap() (privately, so writes of
+ * the program never reach the file), and only partial pages are read.
+ *
+ * Without the kernel there is no file system: only brk() is served. A
+ * program whose image carries a disk after the ELF file (such as PAL with
+ * its data files) must boot through the kernel.
+ */
+
+#define PAGE_SIZE 4096
+#define PAGE_MASK (PAGE_SIZE - 1)
+
+/* the system call numbers of i386 */
+#define SYS_brk 45
+
+#define STACK_TOP (128 << 20)
+
+extern char *exec_file;
+
+/* the program break, above every segment */
+uint32_t boot_brk;
+
+static void read_at(int fd, void *buf, size_t len, off_t offset) {
+	while(len > 0) {
+		ssize_t ret = pread(fd, buf, len, offset);
+		Assert(ret > 0, "Can not read '%s'", exec_file);
+		buf += ret;
+		len -= ret;
+		offset += ret;
+	}
+}
+
+static void load_segment(int fd, Elf32_Phdr *ph) {
+	Assert(ph->p_memsz <= HW_MEM_SIZE && ph->p_vaddr <= HW_MEM_SIZE - ph->p_memsz,
+			"segment at 0x%08x is outside of the physical memory", ph->p_vaddr);
+
+	uint8_t *dst = hwa_to_va(ph->p_vaddr);
+	uint32_t len = ph->p_filesz;
+	uint32_t head = len, body = 0;
+
+	/* The file offset and the address must agree in the page offset. */
+	if(((ph->p_vaddr - ph->p_offset) & PAGE_MASK) == 0) {
+		head = (PAGE_SIZE - (ph->p_vaddr & PAGE_MASK)) & PAGE_MASK;
+		if(head > len) { head = len; }
+		body = (len - head) & ~PAGE_MASK;
+	}
+
+	read_at(fd, dst, head, ph->p_offset);
+	if(body > 0) {
+		void *p = mmap(dst + head, body, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED,
+				fd, ph->p_offset + head);
+		Assert(p != MAP_FAILED, "Can not map '%s'", exec_file);
+	}
+	read_at(fd, dst + head + body, len - head - body, ph->p_offset + head + body);
+
+	/* zero the .bss section */
+	memset(dst + len, 0, ph->p_memsz - len);
+
+	uint32_t end = (ph->p_vaddr + ph->p_memsz + PAGE_MASK) & ~PAGE_MASK;
+	if(end > boot_brk) { boot_brk = end; }
+}
+
+void load_program() {
+	int fd = open(exec_file, O_RDONLY);
+	Assert(fd >= 0, "Can not open '%s'", exec_file);
+
+	Elf32_Ehdr elf;
+	read_at(fd, &elf, sizeof(elf), 0);
+	Assert(elf.e_phentsize == sizeof(Elf32_Phdr), "unexpected program header size %d", elf.e_phentsize);
+
+	Elf32_Phdr ph[elf.e_phnum];
+	read_at(fd, ph, sizeof(ph), elf.e_phoff);
+
+	boot_brk = 0;
+	off_t elf_end = elf.e_shoff + elf.e_shnum * elf.e_shentsize;
+	int i;
+	for(i = 0; i < elf.e_phnum; i ++) {
+		if(ph[i].p_type == PT_LOAD) {
+			load_segment(fd, &ph[i]);
+		}
+		if(ph[i].p_offset + ph[i].p_filesz > elf_end) { elf_end = ph[i].p_offset + ph[i].p_filesz; }
+	}
+
+	/* Anything after the ELF file is a disk, which only the kernel can serve. */
+	struct stat st;
+	Assert(fstat(fd, &st) == 0, "Can not stat '%s'", exec_file);
+	Assert(st.st_size <= elf_end, "'%s' carries a disk after the ELF file, "
+			"which needs the file system of the kernel; boot it without DIRECT_BOOT", exec_file);
+	close(fd);
+
+	/* the same environment as set up by the kernel */
+	cpu.eip = elf.e_entry;
+	cpu.esp = STACK_TOP - 16;
+	cpu.ebp = 0;
+}
+
+/* Serve ``int $0x80'' for the program, as there is no kernel. */
+void boot_syscall() {
+	switch(cpu.eax) {
+		case SYS_brk:
+			if(cpu.ebx > boot_brk) { boot_brk = cpu.ebx; }
+			cpu.eax = 0;
+			break;
+
+		default: panic("Unhandled system call in direct boot: id = %d", cpu.eax);
+	}
+}
+
+#endif
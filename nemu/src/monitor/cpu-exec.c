@@ -1,7 +1,16 @@
 #include "monitor/monitor.h"
 #include "cpu/helper.h"
 #include <setjmp.h>
+#include <time.h>
 #include "monitor/watchpoint.h"
+#include "monitor/opstat.h"
+#include "monitor/trace.h"
+#include "device/replay.h"
+#include "monitor/reverse.h"
+#include "monitor/gdb.h"
+#include "cpu/clock.h"
+#include "device/event.h"
+#include "cpu/intr.h"
 /* The assembly code of instructions executed is only output to the screen
  * when the number of instructions executed is less than this value.
  * This is useful when you use the ``si'' command.
@@ -10,9 +19,14 @@
 #define MAX_INSTR_TO_PRINT 10
 
 int nemu_state = STOP;
+bool nemu_quiet = false;
 
 int exec(swaddr_t);
 
+#ifdef HAS_DEVICE
+void serial_flush();
+#endif
+
 char assembly[80];
 char asm_buf[128];
 
@@ -28,12 +42,113 @@ void print_bin_instr(swaddr_t eip, int len) {
 	sprintf(asm_buf + l, "%*.s", 50 - (12 + 3 * len), "");
 }
 
+/* Host time spent in cpu_exec(), for the last run and in total. */
+static struct {
+	double wall, cpu;
+	uint64_t instr;
+} run_start, last_run, total_run;
+static bool in_run;
+
+static double host_time(clockid_t clk) {
+	struct timespec ts;
+	clock_gettime(clk, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void run_begin() {
+	run_start.wall = host_time(CLOCK_MONOTONIC);
+	run_start.cpu = host_time(CLOCK_PROCESS_CPUTIME_ID);
+	run_start.instr = cpu.instr_cnt;
+	in_run = true;
+}
+
+static void run_end() {
+	last_run.wall = host_time(CLOCK_MONOTONIC) - run_start.wall;
+	last_run.cpu = host_time(CLOCK_PROCESS_CPUTIME_ID) - run_start.cpu;
+	last_run.instr = cpu.instr_cnt - run_start.instr;
+	total_run.wall += last_run.wall;
+	total_run.cpu += last_run.cpu;
+	total_run.instr += last_run.instr;
+	in_run = false;
+}
+
+static void print_run(const char *what, double wall, double cpu_time, uint64_t instr) {
+	printf("%s: instructions: %llu, wall time: %.3f s, CPU time: %.3f s, MIPS: %.2f\n",
+			what, (unsigned long long)instr, wall, cpu_time, (wall > 0 ? instr / wall / 1e6 : 0));
+}
+
+/* Print the statistics of execution, including the current run if it is not finished. */
+void print_exec_stat() {
+	if(in_run) {
+		double wall = host_time(CLOCK_MONOTONIC) - run_start.wall;
+		double cpu_time = host_time(CLOCK_PROCESS_CPUTIME_ID) - run_start.cpu;
+		uint64_t instr = cpu.instr_cnt - run_start.instr;
+		print_run("this run", wall, cpu_time, instr);
+		print_run("total", total_run.wall + wall, total_run.cpu + cpu_time, total_run.instr + instr);
+	}
+	else {
+		print_run("last run", last_run.wall, last_run.cpu, last_run.instr);
+		print_run("total", total_run.wall, total_run.cpu, total_run.instr);
+	}
+#ifdef VIRTUAL_CLOCK
+	printf("virtual clock: %llu cycles, %.6f s at %d MHz\n", (unsigned long long)vclock,
+			(double)vclock / CPU_HZ, CPU_HZ / 1000000);
+#endif
+}
+
 /* This function will be called when an `int3' instruction is being executed. */
 void do_int3() {
-	printf("\nHit breakpoint at eip = 0x%08x\n", cpu.eip);
+	if(!nemu_quiet) {
+		printf("\nHit breakpoint at eip = 0x%08x\n", cpu.eip);
+	}
 	nemu_state = STOP;
 }
 
+/* Lower ``event_deadline'' to the time when the instruction counter
+ * reaches ``count''. The virtual clock advances at least one cycle for
+ * each instruction, so this time is never late.
+ */
+static inline void fold_deadline(uint64_t count) {
+	if(count == ~0ull) { return; }
+	uint64_t when = (count > cpu.instr_cnt ? event_now() + (count - cpu.instr_cnt) : 0);
+	if(when < event_deadline) { event_deadline = when; }
+}
+
+/* Everything to be done between two instructions at a given time is
+ * folded into ``event_deadline'', so the CPU loop only makes one
+ * compare for it: the device events, the replay events and the
+ * checkpoints of reverse execution. A halted CPU stays here, moving
+ * the time from one device event to the next, until an interrupt is
+ * taken.
+ */
+static void exec_deadline() {
+	while(1) {
+		if(cpu.instr_cnt >= replay_deadline) {
+			/* deliver recorded or queued device events */
+			replay_dispatch();
+		}
+
+		/* timer ticks, screen refresh and other device events,
+		 * then the interrupt they may have raised */
+		event_dispatch();
+		intr_deliver();
+
+		if(cpu.instr_cnt >= rev_next_checkpoint) {
+			rev_checkpoint();
+		}
+
+		if(!cpu.halted || nemu_state != RUNNING) { break; }
+
+		/* The instruction counter stands still, so only a device
+		 * event can wake the CPU up. */
+		Assert(event_deadline != ~0ull, "hlt at eip = 0x%08x would never wake up", cpu.eip);
+		event_idle_until(event_deadline);
+	}
+
+	fold_deadline(replay_deadline);
+	fold_deadline(rev_next_checkpoint);
+}
+
 /* Simulate how the CPU works. */
 void cpu_exec(volatile uint32_t n) {
 	if(nemu_state == END) {
@@ -41,17 +156,29 @@ void cpu_exec(volatile uint32_t n) {
 		return;
 	}
 	nemu_state = RUNNING;
+	run_begin();
 
 #ifdef DEBUG
 	volatile uint32_t n_temp = n;
 #endif
 
+	/* The monitor may have moved the deadlines. */
+	event_kick();
+
 	setjmp(jbuf);
 
 	for(; n > 0; n --) {
-#ifdef DEBUG
+		instr_eip = cpu.eip;
+		instr_esp = cpu.esp;
+
+		if(event_now() >= event_deadline) {
+			exec_deadline();
+			if(cpu.halted) { break; }
+		}
+
 		swaddr_t eip_temp = cpu.eip;
-		if((n & 0xffff) == 0) {
+#ifdef DEBUG
+		if((n & 0xffff) == 0 && !nemu_quiet) {
 			/* Output some dots while executing the program. */
 			fputc('.', stderr);
 		}
@@ -59,15 +186,32 @@ void cpu_exec(volatile uint32_t n) {
 
 		/* Execute one instruction, including instruction fetch,
 		 * instruction decode, and the actual execution. */
+#ifdef OPCODE_STAT
+		uint64_t tsc_temp = rdtsc();
+		int instr_len = exec(cpu.eip);
+		opstat_record(ops_decoded.opcode, rdtsc() - tsc_temp);
+#else
 		int instr_len = exec(cpu.eip);
+#endif
 
 		cpu.eip += instr_len;
+		cpu.instr_cnt ++;
+		clock_advance(instr_cycles[ops_decoded.opcode]);
+
+		if(trace_on) {
+			trace_instr(eip_temp, instr_len);
+		}
 
 #ifdef DEBUG
-		print_bin_instr(eip_temp, instr_len);
-		strcat(asm_buf, assembly);
-		Log_write("%s\n", asm_buf);
-		if(n_temp < MAX_INSTR_TO_PRINT) {
+		/* The binary trace replaces the text log, which is much slower. */
+		if(!trace_on || n_temp < MAX_INSTR_TO_PRINT) {
+			print_bin_instr(eip_temp, instr_len);
+			strcat(asm_buf, assembly);
+		}
+		if(!trace_on) {
+			Log_write("%s\n", asm_buf);
+		}
+		if(n_temp < MAX_INSTR_TO_PRINT && !nemu_quiet) {
 			printf("%s\n", asm_buf);
 		}
 #endif
@@ -75,8 +219,22 @@ void cpu_exec(volatile uint32_t n) {
 		/* TODO: check watchpoints here. */
 		check_wp(&nemu_state);
 
-		if(nemu_state != RUNNING) { return; }
+		/* stop before the instruction at a GDB breakpoint */
+		if(gdb_check_bp(cpu.eip)) {
+			nemu_state = STOP;
+		}
+
+		if(nemu_state != RUNNING) { break; }
 	}
 
 	if(nemu_state == RUNNING) { nemu_state = STOP; }
+	run_end();
+	if(nemu_state == END && !nemu_quiet) {
+		/* the statistics count the trapping instruction */
+		print_exec_stat();
+		printf("\n");
+	}
+#ifdef HAS_DEVICE
+	serial_flush();
+#endif
 }
@@ -284,7 +284,12 @@ int eval(int p, int q, bool *success) {
 		return -eval(p + 1, q, success);
 	} 
 	else if(tokens[p].type == REF) {
-		return (int)swaddr_read(eval(p + 1, q, success), 4);
+		uint32_t val;
+		if(!swaddr_debug_read(eval(p + 1, q, success), 4, R_DS, &val)) {
+			*success = false;
+			return 0;
+		}
+		return val;
 	}
 	else if(tokens[p].type == '!') {
 		return !eval(p + 1, q, success);
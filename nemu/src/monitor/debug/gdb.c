@@ -0,0 +1,438 @@
+#include "nemu.h"
+#include "monitor/monitor.h"
+#include "monitor/gdb.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/* A stub of the GDB remote serial protocol.
+ *
+ * ``gdb [port|path]'' waits for GDB on a TCP port of localhost or on a
+ * Unix socket, then serves its requests until GDB detaches. Registers
+ * follow the i386 layout of GDB: eax, ecx, edx, ebx, esp, ebp, esi, edi,
+ * eip, eflags, cs, ss, ds, es, then fs and gs which always read as zero.
+ *
+ * Breakpoints (Z0 and Z1 are the same here) are looked up in a small
+ * hashed map by the CPU loop. Write watchpoints (Z2) are checked in
+ * swaddr_write() only when at least one of them is set.
+ */
+
+#define NR_BP 64
+#define NR_WATCH 4
+#define PACKET_SIZE 4096
+#define NR_REG 16
+/* the number of instructions executed between two polls of the socket */
+#define POLL_INTERVAL 0x10000
+
+uint8_t gdb_bp_map[GDB_BP_MAP_SIZE];
+bool gdb_watch_on = false;
+
+static swaddr_t bp[NR_BP];
+int gdb_nr_bp = 0;
+
+static struct {
+	swaddr_t addr;
+	size_t len;
+} watch[NR_WATCH];
+static int nr_watch;
+static bool watch_hit;
+static swaddr_t watch_addr;
+
+static int conn = -1;
+
+void cpu_exec(uint32_t);
+
+bool gdb_bp_hit(swaddr_t eip) {
+	int i;
+	for(i = 0; i < gdb_nr_bp; i ++) {
+		if(bp[i] == eip) { return true; }
+	}
+	return false;
+}
+
+void gdb_watch_write(swaddr_t addr, size_t len) {
+	int i;
+	for(i = 0; i < nr_watch; i ++) {
+		if(addr < watch[i].addr + watch[i].len && watch[i].addr < addr + len) {
+			watch_hit = true;
+			watch_addr = watch[i].addr;
+			nemu_state = STOP;
+		}
+	}
+}
+
+static bool insert_bp(swaddr_t addr) {
+	if(gdb_nr_bp == NR_BP) { return false; }
+	bp[gdb_nr_bp ++] = addr;
+	gdb_bp_map[addr & (GDB_BP_MAP_SIZE - 1)] ++;
+	return true;
+}
+
+static bool remove_bp(swaddr_t addr) {
+	int i;
+	for(i = 0; i < gdb_nr_bp; i ++) {
+		if(bp[i] == addr) {
+			bp[i] = bp[-- gdb_nr_bp];
+			gdb_bp_map[addr & (GDB_BP_MAP_SIZE - 1)] --;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool insert_watch(swaddr_t addr, size_t len) {
+	if(nr_watch == NR_WATCH) { return false; }
+	watch[nr_watch].addr = addr;
+	watch[nr_watch].len = len;
+	nr_watch ++;
+	gdb_watch_on = true;
+	return true;
+}
+
+static bool remove_watch(swaddr_t addr, size_t len) {
+	int i;
+	for(i = 0; i < nr_watch; i ++) {
+		if(watch[i].addr == addr && watch[i].len == len) {
+			watch[i] = watch[-- nr_watch];
+			gdb_watch_on = (nr_watch != 0);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void clear_points() {
+	while(gdb_nr_bp > 0) { remove_bp(bp[gdb_nr_bp - 1]); }
+	nr_watch = 0;
+	gdb_watch_on = false;
+}
+
+static uint32_t get_reg(int i) {
+	if(i < 8) { return cpu.gpr[i]._32; }
+	if(i == 8) { return cpu.eip; }
+	if(i == 9) { return cpu.eflags; }
+	if(i == 10) { return cpu.sreg[R_CS].val; }
+	if(i == 11) { return cpu.sreg[R_SS].val; }
+	if(i == 12) { return cpu.sreg[R_DS].val; }
+	if(i == 13) { return cpu.sreg[R_ES].val; }
+	return 0;
+}
+
+static void set_reg(int i, uint32_t v) {
+	if(i < 8) { cpu.gpr[i]._32 = v; }
+	else if(i == 8) { cpu.eip = v; }
+	else if(i == 9) { cpu.eflags = v | 0x2; }
+}
+
+/* packet I/O */
+
+static const char hex[] = "0123456789abcdef";
+
+static int from_hex(char c) {
+	if(c >= '0' && c <= '9') { return c - '0'; }
+	if(c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+	if(c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+	return -1;
+}
+
+/* Write a 32-bit value in target (little endian) byte order. */
+static char *put_word(char *p, uint32_t v) {
+	int i;
+	for(i = 0; i < 4; i ++, v >>= 8) {
+		*p ++ = hex[(v >> 4) & 0xf];
+		*p ++ = hex[v & 0xf];
+	}
+	return p;
+}
+
+static uint32_t get_word(const char *p) {
+	uint32_t v = 0;
+	int i;
+	for(i = 3; i >= 0; i --) {
+		v = (v << 8) | (from_hex(p[i * 2]) << 4) | from_hex(p[i * 2 + 1]);
+	}
+	return v;
+}
+
+static bool send_all(const char *buf, size_t len) {
+	while(len > 0) {
+		ssize_t ret = write(conn, buf, len);
+		if(ret <= 0) { return false; }
+		buf += ret;
+		len -= ret;
+	}
+	return true;
+}
+
+static int get_char() {
+	unsigned char c;
+	return (read(conn, &c, 1) == 1 ? c : -1);
+}
+
+static bool send_packet(const char *data) {
+	static char buf[PACKET_SIZE * 2 + 8];
+	uint8_t sum = 0;
+	int len = 0, c;
+	buf[len ++] = '$';
+	for(; *data; data ++) {
+		sum += *data;
+		buf[len ++] = *data;
+	}
+	buf[len ++] = '#';
+	buf[len ++] = hex[sum >> 4];
+	buf[len ++] = hex[sum & 0xf];
+
+	do {
+		if(!send_all(buf, len)) { return false; }
+		c = get_char();
+	} while(c == '-');
+	return c == '+';
+}
+
+/* Receive a packet into ``buf''. Return false if the connection is closed. */
+static bool recv_packet(char *buf) {
+	int c;
+	while(true) {
+		while((c = get_char()) != '$') {
+			if(c < 0) { return false; }
+		}
+
+		int len = 0;
+		uint8_t sum = 0;
+		while((c = get_char()) != '#') {
+			if(c < 0) { return false; }
+			if(len < PACKET_SIZE - 1) { buf[len ++] = c; }
+			sum += c;
+		}
+		buf[len] = '\0';
+
+		int hi = get_char(), lo = get_char();
+		if(lo < 0) { return false; }
+		if(((from_hex(hi) << 4) | from_hex(lo)) == sum) {
+			return send_all("+", 1);
+		}
+		if(!send_all("-", 1)) { return false; }
+	}
+}
+
+/* Check whether GDB has sent an interrupt (Ctrl-C) without blocking. */
+static bool interrupted() {
+	struct pollfd pfd = { .fd = conn, .events = POLLIN };
+	if(poll(&pfd, 1, 0) <= 0) { return false; }
+	char c;
+	if(recv(conn, &c, 1, MSG_PEEK) != 1 || c != 0x03) { return false; }
+	return read(conn, &c, 1) == 1;
+}
+
+/* execution control */
+
+static void stop_reply(char *out) {
+	if(nemu_state == END) {
+		sprintf(out, "W%02x", cpu.eax & 0xff);
+	}
+	else if(watch_hit) {
+		sprintf(out, "T05watch:%x;", watch_addr);
+	}
+	else {
+		strcpy(out, "S05");
+	}
+}
+
+static void do_continue(bool step) {
+	watch_hit = false;
+	if(nemu_state == END) { return; }
+
+	nemu_quiet = true;
+	if(step) {
+		cpu_exec(1);
+	}
+	else {
+		while(true) {
+			uint64_t start = cpu.instr_cnt;
+			cpu_exec(POLL_INTERVAL);
+			/* stopped by a breakpoint, a watchpoint or the end of the program */
+			if(nemu_state != STOP || cpu.instr_cnt - start < POLL_INTERVAL ||
+					watch_hit || gdb_check_bp(cpu.eip)) { break; }
+			if(interrupted()) { break; }
+		}
+	}
+	nemu_quiet = false;
+}
+
+/* Handle one packet. Return false when GDB detaches or kills. */
+static bool handle(char *in, char *out) {
+	char *p;
+	uint32_t addr, len, v;
+	int i, type;
+	out[0] = '\0';
+
+	switch(in[0]) {
+		case '?':
+			stop_reply(out);
+			break;
+
+		case 'g':
+			for(p = out, i = 0; i < NR_REG; i ++) {
+				p = put_word(p, get_reg(i));
+			}
+			*p = '\0';
+			break;
+
+		case 'G':
+			for(i = 0; i < NR_REG && strlen(in + 1) >= (i + 1) * 8; i ++) {
+				set_reg(i, get_word(in + 1 + i * 8));
+			}
+			strcpy(out, "OK");
+			break;
+
+		case 'p':
+			i = strtoul(in + 1, NULL, 16);
+			*put_word(out, (i < NR_REG ? get_reg(i) : 0)) = '\0';
+			break;
+
+		case 'P':
+			i = strtoul(in + 1, &p, 16);
+			if(*p != '=' || i >= NR_REG) { strcpy(out, "E01"); break; }
+			set_reg(i, get_word(p + 1));
+			strcpy(out, "OK");
+			break;
+
+		case 'm':
+			addr = strtoul(in + 1, &p, 16);
+			len = strtoul(p + 1, NULL, 16);
+			if(len > PACKET_SIZE / 2 - 1) { strcpy(out, "E14"); break; }
+			for(p = out; len > 0; len --, addr ++) {
+				if(!swaddr_debug_read(addr, 1, R_DS, &v)) { break; }
+				*p ++ = hex[v >> 4];
+				*p ++ = hex[v & 0xf];
+			}
+			/* an unreadable byte fails the whole request */
+			if(len > 0) { strcpy(out, "E14"); break; }
+			*p = '\0';
+			break;
+
+		case 'M':
+			addr = strtoul(in + 1, &p, 16);
+			len = strtoul(p + 1, &p, 16);
+			if(*p != ':' || strlen(p + 1) < len * 2) { strcpy(out, "E14"); break; }
+			for(p ++; len > 0; len --, addr ++, p += 2) {
+				if(!swaddr_debug_write(addr, 1, (from_hex(p[0]) << 4) | from_hex(p[1]), R_DS)) { break; }
+			}
+			strcpy(out, (len > 0 ? "E14" : "OK"));
+			break;
+
+		case 'c':
+		case 's':
+			if(in[1] != '\0') { cpu.eip = strtoul(in + 1, NULL, 16); }
+			do_continue(in[0] == 's');
+			stop_reply(out);
+			break;
+
+		case 'Z':
+		case 'z':
+			type = strtoul(in + 1, &p, 16);
+			addr = strtoul(p + 1, &p, 16);
+			len = strtoul(p + 1, NULL, 16);
+			if(type == 0 || type == 1) {
+				bool ok = (in[0] == 'Z' ? insert_bp(addr) : remove_bp(addr));
+				strcpy(out, ok ? "OK" : "E01");
+			}
+			else if(type == 2) {
+				bool ok = (in[0] == 'Z' ? insert_watch(addr, len) : remove_watch(addr, len));
+				strcpy(out, ok ? "OK" : "E01");
+			}
+			/* read and access watchpoints are not supported */
+			break;
+
+		case 'q':
+			if(strncmp(in, "qSupported", 10) == 0) {
+				sprintf(out, "PacketSize=%x", PACKET_SIZE);
+			}
+			else if(strcmp(in, "qAttached") == 0) {
+				strcpy(out, "1");
+			}
+			else if(strcmp(in, "qC") == 0) {
+				strcpy(out, "QC1");
+			}
+			break;
+
+		case 'H':
+			strcpy(out, "OK");
+			break;
+
+		case 'D':
+			send_packet("OK");
+			return false;
+
+		case 'k':
+			return false;
+
+		default:
+			/* unsupported packets are answered with an empty reply */
+			break;
+	}
+	return true;
+}
+
+static int listen_on(const char *where) {
+	int fd;
+	if(strchr(where, '/') != NULL) {
+		struct sockaddr_un sa = { .sun_family = AF_UNIX };
+		strncpy(sa.sun_path, where, sizeof(sa.sun_path) - 1);
+		unlink(where);
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(fd < 0 || bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) { goto fail; }
+	}
+	else {
+		struct sockaddr_in sa = { .sin_family = AF_INET };
+		sa.sin_port = htons(atoi(where));
+		sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		int one = 1;
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if(fd < 0) { goto fail; }
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+		if(bind(fd, (struct sockaddr *)&sa, sizeof(sa)) < 0) { goto fail; }
+	}
+
+	if(listen(fd, 1) < 0) { goto fail; }
+	return fd;
+
+fail:
+	perror("gdb");
+	if(fd >= 0) { close(fd); }
+	return -1;
+}
+
+void gdb_serve(const char *where) {
+	int fd = listen_on(where);
+	if(fd < 0) { return; }
+
+	printf("Waiting for GDB on %s%s\n", (strchr(where, '/') ? "" : "localhost:"), where);
+	fflush(stdout);
+	conn = accept(fd, NULL, NULL);
+	close(fd);
+	if(conn < 0) {
+		perror("gdb");
+		return;
+	}
+
+	int one = 1;
+	setsockopt(conn, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	static char in[PACKET_SIZE], out[PACKET_SIZE];
+	while(recv_packet(in)) {
+		if(!handle(in, out)) { break; }
+		if(!send_packet(out)) { break; }
+	}
+
+	close(conn);
+	conn = -1;
+	clear_points();
+	printf("GDB detached at eip = 0x%08x\n", cpu.eip);
+}
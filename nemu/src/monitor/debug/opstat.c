@@ -0,0 +1,91 @@
+#include "monitor/opstat.h"
+
+#ifdef OPCODE_STAT
+
+#include <stdlib.h>
+
+/* opcodes of the 2-byte opcode table are recorded as (0x100 | opcode) */
+#define NR_OPCODE 512
+
+/* The ModR/M form of an instruction is its ``mod'' field (0 ~ 3).
+ * Instructions without ModR/M byte are counted as MODRM_NONE.
+ */
+#define MODRM_NONE 4
+#define NR_FORM 5
+
+typedef struct {
+	uint64_t count;
+	uint64_t cycles;
+	uint64_t form[NR_FORM];
+} OpStat;
+
+static OpStat stat[NR_OPCODE];
+static int cur_form = MODRM_NONE;
+
+/* Called by the ModR/M decoder to tell which form the current instruction uses. */
+void opstat_modrm(int mod) {
+	cur_form = mod;
+}
+
+/* Called after an instruction is executed. ``opcode'' is the one
+ * left in ``ops_decoded'', so prefixes are accounted to the
+ * instruction they modify.
+ */
+void opstat_record(uint32_t opcode, uint64_t cycles) {
+	OpStat *s = &stat[opcode & (NR_OPCODE - 1)];
+	s->count ++;
+	s->cycles += cycles;
+	s->form[cur_form] ++;
+	cur_form = MODRM_NONE;
+}
+
+void opstat_reset() {
+	memset(stat, 0, sizeof(stat));
+	cur_form = MODRM_NONE;
+}
+
+static int cmp_count(const void *a, const void *b) {
+	uint64_t x = stat[*(const int *)a].count;
+	uint64_t y = stat[*(const int *)b].count;
+	return (x < y) - (x > y);
+}
+
+void opstat_report() {
+	static int idx[NR_OPCODE];
+	uint64_t total = 0, total_cycles = 0;
+	int i, n = 0;
+	for(i = 0; i < NR_OPCODE; i ++) {
+		if(stat[i].count) {
+			idx[n ++] = i;
+			total += stat[i].count;
+			total_cycles += stat[i].cycles;
+		}
+	}
+
+	if(total == 0) {
+		printf("No instruction has been executed.\n");
+		return;
+	}
+
+	qsort(idx, n, sizeof(idx[0]), cmp_count);
+
+	printf("%-8s %14s %7s %16s %8s %12s %12s %12s %12s\n", "opcode", "count", "%",
+			"host cycles", "cyc/ins", "mod=0", "mod=1", "mod=2", "mod=3");
+	for(i = 0; i < n; i ++) {
+		OpStat *s = &stat[idx[i]];
+		char name[8];
+		if(idx[i] & 0x100) { sprintf(name, "0f %02x", idx[i] & 0xff); }
+		else { sprintf(name, "%02x", idx[i]); }
+
+		printf("%-8s %14llu %6.2f%% %16llu %8.1f %12llu %12llu %12llu %12llu\n", name,
+				(unsigned long long)s->count, 100.0 * s->count / total,
+				(unsigned long long)s->cycles, (double)s->cycles / s->count,
+				(unsigned long long)s->form[0], (unsigned long long)s->form[1],
+				(unsigned long long)s->form[2], (unsigned long long)s->form[3]);
+	}
+	printf("total: %llu instructions, %llu host cycles, %.1f cycles per instruction\n",
+			(unsigned long long)total, (unsigned long long)total_cycles,
+			(double)total_cycles / total);
+}
+
+#endif
@@ -0,0 +1,291 @@
+#include "nemu.h"
+#include "monitor/monitor.h"
+#include "monitor/reverse.h"
+#include "device/replay.h"
+#include "device/event.h"
+
+#include <stdlib.h>
+
+/* Reverse execution.
+ *
+ * A checkpoint is taken every ``interval'' instructions. It holds the
+ * CPU state and, instead of a copy of the whole memory, the old content
+ * of every page written after the checkpoint is taken. Rolling back to
+ * a checkpoint restores the saved pages of it and of all newer ones,
+ * from the newest to the oldest. Device inputs are kept in the journal
+ * of replay.c, so re-executing from a checkpoint is deterministic.
+ *
+ * The oldest checkpoints are dropped when the number of checkpoints or
+ * the memory used by the saved pages exceeds the budget. The time of
+ * the event clock is checkpointed with the CPU, but the internal state
+ * of devices is not: the checkpoints before the last device access of
+ * the guest are dropped, and the machine is never rolled back past it.
+ */
+
+#define REV_PAGE_SIZE (1 << REV_PAGE_SHIFT)
+#define NR_CHECKPOINT 1024
+
+typedef struct {
+	CPU_state cpu;
+	uint64_t clock;
+	int nr_page, cap;
+	uint32_t *page_no;
+	uint8_t *data;
+} Checkpoint;
+
+bool rev_on = false;
+uint64_t rev_next_checkpoint = ~0ull;
+/* the checkpoints before this instruction count can not be restored */
+uint64_t rev_barrier = 0;
+uint8_t rev_page_saved[REV_NR_PAGE];
+
+/* checkpoints, as a ring from the oldest to the newest */
+static Checkpoint cp[NR_CHECKPOINT];
+static int cp_first, nr_cp;
+
+static uint64_t interval;
+static size_t budget, mem_used;
+
+void init_ddr3();
+void update_wp();
+void cpu_exec(uint32_t);
+
+#define CP(i) (&cp[(cp_first + (i)) % NR_CHECKPOINT])
+
+static void free_checkpoint(Checkpoint *c) {
+	mem_used -= c->cap * (REV_PAGE_SIZE + sizeof(uint32_t));
+	free(c->page_no);
+	free(c->data);
+	memset(c, 0, sizeof(*c));
+}
+
+static void drop_oldest() {
+	free_checkpoint(CP(0));
+	cp_first = (cp_first + 1) % NR_CHECKPOINT;
+	nr_cp --;
+	journal_trim(CP(0)->cpu.instr_cnt);
+}
+
+/* The host address of a page of the DRAM or the ramdisk. */
+static uint8_t *page_ptr(uint32_t page) {
+	hwaddr_t addr = page << REV_PAGE_SHIFT;
+#ifdef USE_RAMDISK
+	if(addr >= RAMDISK_BASE) {
+		return &ramdisk_rw(addr, uint8_t);
+	}
+#endif
+	return hw_mem + addr;
+}
+
+void rev_save_page(hwaddr_t addr) {
+	uint32_t page = addr >> REV_PAGE_SHIFT;
+	Checkpoint *c = CP(nr_cp - 1);
+	if(c->nr_page == c->cap) {
+		int new_cap = (c->cap == 0 ? 16 : c->cap * 2);
+		c->page_no = realloc(c->page_no, new_cap * sizeof(uint32_t));
+		c->data = realloc(c->data, (size_t)new_cap * REV_PAGE_SIZE);
+		assert(c->page_no && c->data);
+		mem_used += (new_cap - c->cap) * (REV_PAGE_SIZE + sizeof(uint32_t));
+		c->cap = new_cap;
+	}
+
+	c->page_no[c->nr_page] = page;
+	memcpy(c->data + (size_t)c->nr_page * REV_PAGE_SIZE, page_ptr(page), REV_PAGE_SIZE);
+	c->nr_page ++;
+	rev_page_saved[page] = true;
+
+	while(mem_used > budget && nr_cp > 1) {
+		drop_oldest();
+	}
+}
+
+void rev_checkpoint() {
+	while(nr_cp > 0 && (nr_cp == NR_CHECKPOINT || CP(0)->cpu.instr_cnt < rev_barrier)) {
+		drop_oldest();
+	}
+
+	Checkpoint *c = CP(nr_cp);
+	nr_cp ++;
+	c->cpu = cpu;
+#ifdef VIRTUAL_CLOCK
+	c->clock = vclock;
+#else
+	c->clock = event_idle;
+#endif
+	c->nr_page = 0;
+	memset(rev_page_saved, false, sizeof(rev_page_saved));
+	rev_next_checkpoint = cpu.instr_cnt + interval;
+}
+
+void rev_start(uint64_t new_interval, size_t new_budget) {
+	if(rev_on) {
+		printf("Reverse execution is already on\n");
+		return;
+	}
+	if(replay_mode != REPLAY_OFF) {
+		printf("Can not start reverse execution while recording or replaying\n");
+		return;
+	}
+
+	interval = new_interval;
+	budget = new_budget;
+	cp_first = nr_cp = 0;
+	mem_used = 0;
+	rev_barrier = 0;
+	journal_start();
+	rev_on = true;
+	rev_checkpoint();
+}
+
+void rev_stop() {
+	if(!rev_on) {
+		return;
+	}
+
+	while(nr_cp > 0) {
+		free_checkpoint(CP(nr_cp - 1));
+		nr_cp --;
+	}
+	rev_on = false;
+	rev_next_checkpoint = ~0ull;
+	journal_stop();
+}
+
+/* Roll the machine back to the i-th checkpoint. Newer checkpoints are dropped. */
+static void restore(int i) {
+	uint64_t present = cpu.instr_cnt;
+	int j, k;
+	for(j = nr_cp - 1; j >= i; j --) {
+		Checkpoint *c = CP(j);
+		for(k = c->nr_page - 1; k >= 0; k --) {
+			memcpy(page_ptr(c->page_no[k]), c->data + (size_t)k * REV_PAGE_SIZE, REV_PAGE_SIZE);
+		}
+	}
+
+	while(nr_cp > i + 1) {
+		free_checkpoint(CP(nr_cp - 1));
+		nr_cp --;
+	}
+
+	Checkpoint *c = CP(i);
+	cpu = c->cpu;
+#ifdef VIRTUAL_CLOCK
+	vclock = c->clock;
+#else
+	event_idle = c->clock;
+#endif
+	memset(rev_page_saved, false, sizeof(rev_page_saved));
+	for(k = 0; k < c->nr_page; k ++) {
+		rev_page_saved[c->page_no[k]] = true;
+	}
+	rev_next_checkpoint = cpu.instr_cnt + interval;
+
+	/* The row buffers hold the old content of DRAM. */
+	init_ddr3();
+	page_flush();
+
+	nemu_state = STOP;
+	journal_rewind(present);
+}
+
+/* Find the newest checkpoint taken no later than instruction ``count''. */
+static int find_checkpoint(uint64_t count) {
+	int i;
+	for(i = nr_cp - 1; i > 0 && CP(i)->cpu.instr_cnt > count; i --);
+	return i;
+}
+
+/* Execute silently until ``target'' instructions have been retired.
+ * Return the instruction count of the last stop caused by watchpoints
+ * or breakpoints before ``target'', or 0 if there is no such stop.
+ */
+static uint64_t run_to(uint64_t target) {
+	uint64_t last_stop = 0;
+	nemu_quiet = true;
+	update_wp();
+	while(cpu.instr_cnt < target && nemu_state != END) {
+		uint64_t n = target - cpu.instr_cnt;
+		cpu_exec(n > 0x7fffffff ? 0x7fffffff : n);
+		if(cpu.instr_cnt < target && nemu_state == STOP) {
+			last_stop = cpu.instr_cnt;
+		}
+	}
+	nemu_quiet = false;
+	update_wp();
+	return last_stop;
+}
+
+/* Whether no checkpoint has been taken since the last device access. */
+static bool blocked_by_device() {
+	if(CP(nr_cp - 1)->cpu.instr_cnt >= rev_barrier) {
+		return false;
+	}
+	printf("Can not go back past the device access at instruction %llu\n",
+			(unsigned long long)rev_barrier - 1);
+	return true;
+}
+
+static void report() {
+	printf("Now at instruction %llu, eip = 0x%08x\n",
+			(unsigned long long)cpu.instr_cnt, cpu.eip);
+}
+
+/* Step back ``n'' instructions. */
+void rev_step(uint64_t n) {
+	if(!rev_on) {
+		printf("Reverse execution is off, turn it on with \"rev on\"\n");
+		return;
+	}
+	if(blocked_by_device()) {
+		return;
+	}
+
+	uint64_t oldest = CP(0)->cpu.instr_cnt;
+	uint64_t target = (cpu.instr_cnt - oldest > n ? cpu.instr_cnt - n : oldest);
+	restore(find_checkpoint(target));
+	run_to(target);
+	report();
+}
+
+/* Run backward to the last stop of watchpoints or breakpoints. */
+void rev_continue() {
+	if(!rev_on) {
+		printf("Reverse execution is off, turn it on with \"rev on\"\n");
+		return;
+	}
+	if(blocked_by_device()) {
+		return;
+	}
+
+	uint64_t end = cpu.instr_cnt;
+	int i;
+	for(i = nr_cp - 1; i >= 0; i --) {
+		uint64_t start = CP(i)->cpu.instr_cnt;
+		if(start >= end) { continue; }
+
+		restore(i);
+		uint64_t stop = run_to(end);
+		if(stop != 0) {
+			restore(find_checkpoint(stop));
+			run_to(stop);
+			report();
+			return;
+		}
+		end = start;
+	}
+
+	restore(0);
+	printf("Reached the oldest checkpoint\n");
+	report();
+}
+
+void rev_info() {
+	if(!rev_on) {
+		printf("Reverse execution is off\n");
+		return;
+	}
+
+	printf("%d checkpoints, every %llu instructions, from instruction %llu\n",
+			nr_cp, (unsigned long long)interval, (unsigned long long)CP(0)->cpu.instr_cnt);
+	printf("%zu KB of %zu KB budget used\n", mem_used >> 10, budget >> 10);
+}
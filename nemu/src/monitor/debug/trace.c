@@ -0,0 +1,204 @@
+#include "nemu.h"
+#include "cpu/helper.h"
+#include "monitor/trace.h"
+
+#include <pthread.h>
+
+/* The trace is encoded into a ring of chunks. A full chunk is handed
+ * to the writer thread, which flushes it to the trace file, so the
+ * CPU loop never waits for the host I/O unless the whole ring is full.
+ */
+#define TRACE_CHUNK_SIZE (1 << 20)
+#define NR_TRACE_CHUNK 16
+
+/* the longest record: tag + eip + 31 instruction bytes + bitmap + registers */
+#define TRACE_MAX_RECORD 128
+
+/* instructions whose bytes have been recorded, direct-mapped by eip */
+#define NR_SEEN_EIP 4096
+
+bool trace_on = false;
+bool trace_mem_on = false;
+
+static uint8_t ring[NR_TRACE_CHUNK][TRACE_CHUNK_SIZE];
+static size_t chunk_len[NR_TRACE_CHUNK];
+static int head, tail, nr_full;
+static size_t pos;
+static bool writer_exit;
+
+static pthread_t writer;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t has_data = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t has_space = PTHREAD_COND_INITIALIZER;
+
+static FILE *trace_fp;
+static uint32_t options;
+static swaddr_t next_eip;
+static swaddr_t last_mem_addr;
+static uint32_t last_regs[TRACE_NR_REG];
+static swaddr_t seen_eip[NR_SEEN_EIP];
+
+static void *trace_writer(void *arg) {
+	pthread_mutex_lock(&lock);
+	while(1) {
+		while(nr_full == 0 && !writer_exit) {
+			pthread_cond_wait(&has_data, &lock);
+		}
+		if(nr_full == 0) { break; }
+
+		int idx = tail;
+		pthread_mutex_unlock(&lock);
+		size_t ret = fwrite(ring[idx], 1, chunk_len[idx], trace_fp);
+		Assert(ret == chunk_len[idx], "Can not write the trace file");
+		pthread_mutex_lock(&lock);
+
+		tail = (tail + 1) % NR_TRACE_CHUNK;
+		nr_full --;
+		pthread_cond_signal(&has_space);
+	}
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+/* Hand the current chunk to the writer thread. The next chunk to fill
+ * must not be one the writer has not flushed yet, so at most
+ * NR_TRACE_CHUNK - 1 chunks are waiting for the writer.
+ */
+static void submit_chunk() {
+	pthread_mutex_lock(&lock);
+	while(nr_full >= NR_TRACE_CHUNK - 1) {
+		pthread_cond_wait(&has_space, &lock);
+	}
+	chunk_len[head] = pos;
+	head = (head + 1) % NR_TRACE_CHUNK;
+	nr_full ++;
+	pthread_cond_signal(&has_data);
+	pthread_mutex_unlock(&lock);
+	pos = 0;
+}
+
+static inline uint8_t *reserve() {
+	if(pos + TRACE_MAX_RECORD > TRACE_CHUNK_SIZE) {
+		submit_chunk();
+	}
+	return ring[head] + pos;
+}
+
+static void get_regs(uint32_t *regs) {
+	int i;
+	for(i = R_EAX; i <= R_EDI; i ++) {
+		regs[i] = reg_l(i);
+	}
+	regs[TRACE_REG_EFLAGS] = cpu.eflags;
+}
+
+bool trace_start(const char *filename, uint32_t opt) {
+	if(trace_on) {
+		trace_stop();
+	}
+
+	trace_fp = fopen(filename, "wb");
+	if(trace_fp == NULL) {
+		return false;
+	}
+
+	TraceHeader h;
+	memcpy(h.magic, TRACE_MAGIC, sizeof(h.magic));
+	h.options = opt;
+	h.start_eip = cpu.eip;
+	get_regs(h.start_regs);
+	int ret = fwrite(&h, sizeof(h), 1, trace_fp);
+	assert(ret == 1);
+
+	options = opt;
+	next_eip = cpu.eip;
+	last_mem_addr = 0;
+	memcpy(last_regs, h.start_regs, sizeof(last_regs));
+	memset(seen_eip, 0xff, sizeof(seen_eip));
+
+	head = tail = nr_full = 0;
+	pos = 0;
+	writer_exit = false;
+	ret = pthread_create(&writer, NULL, trace_writer, NULL);
+	Assert(ret == 0, "Can not create the trace writer thread");
+
+	trace_mem_on = (opt & TRACE_OPT_MEM) != 0;
+	trace_on = true;
+	return true;
+}
+
+void trace_stop() {
+	if(!trace_on) {
+		return;
+	}
+
+	trace_on = false;
+	trace_mem_on = false;
+	if(pos > 0) {
+		submit_chunk();
+	}
+
+	pthread_mutex_lock(&lock);
+	writer_exit = true;
+	pthread_cond_signal(&has_data);
+	pthread_mutex_unlock(&lock);
+	pthread_join(writer, NULL);
+
+	fclose(trace_fp);
+	trace_fp = NULL;
+}
+
+/* Record an instruction which has just been executed. */
+void trace_instr(swaddr_t eip, int len) {
+	assert(len > 0 && len <= TRACE_LEN_MASK);
+	uint8_t *p = reserve();
+	uint8_t *tag = p ++;
+	*tag = TRACE_TAG_INSTR | len;
+
+	p += varint_encode(p, zigzag_encode(eip - next_eip));
+	next_eip = eip + len;
+
+	swaddr_t *seen = &seen_eip[eip % NR_SEEN_EIP];
+	if(*seen != eip) {
+		*seen = eip;
+		*tag |= TRACE_HAS_BYTES;
+		int i;
+		for(i = 0; i < len; i ++) {
+			*p ++ = instr_fetch(eip + i, 1);
+		}
+	}
+
+	if(options & TRACE_OPT_REGS) {
+		uint32_t regs[TRACE_NR_REG];
+		uint32_t mask = 0;
+		int i;
+		get_regs(regs);
+		for(i = 0; i < TRACE_NR_REG; i ++) {
+			if(regs[i] != last_regs[i]) { mask |= 1 << i; }
+		}
+
+		if(mask) {
+			*tag |= TRACE_HAS_REGS;
+			p += varint_encode(p, mask);
+			for(i = 0; i < TRACE_NR_REG; i ++) {
+				if(mask & (1 << i)) {
+					p += varint_encode(p, regs[i]);
+					last_regs[i] = regs[i];
+				}
+			}
+		}
+	}
+
+	pos = p - ring[head];
+}
+
+/* Record a memory write issued by the instruction being executed. */
+void trace_mem_write(swaddr_t addr, size_t len, uint32_t data) {
+	uint8_t *p = reserve();
+	*p ++ = len;
+	p += varint_encode(p, zigzag_encode(addr - last_mem_addr));
+	p += varint_encode(p, data);
+	last_mem_addr = addr;
+
+	pos = p - ring[head];
+}
@@ -1,6 +1,11 @@
 #include "monitor/monitor.h"
 #include "monitor/expr.h"
 #include "monitor/watchpoint.h"
+#include "monitor/opstat.h"
+#include "monitor/trace.h"
+#include "monitor/reverse.h"
+#include "monitor/gdb.h"
+#include "device/replay.h"
 #include "nemu.h"
 
 #include <stdlib.h>
@@ -34,6 +39,12 @@ static int cmd_c(char *args) {
 }
 
 static int cmd_q(char *args) {
+	trace_stop();
+	replay_stop();
+	rev_stop();
+#ifdef OPCODE_STAT
+	opstat_report();
+#endif
 	return -1;
 }
 
@@ -74,6 +85,16 @@ static int cmd_info(char *args) {
 	else if(ch == 'w') {
 		print_wp();
 	}
+	else if(ch == 'c') {
+		printf("instructions: %llu\n", (unsigned long long)cpu.instr_cnt);
+		print_exec_stat();
+	}
+#ifdef OPCODE_STAT
+	else if(ch == 's') {
+		if(strstr(args, "reset") != NULL) { opstat_reset(); }
+		else { opstat_report(); }
+	}
+#endif
 	else {
 		printf("Command error!");
 	}
@@ -125,23 +146,127 @@ static int cmd_w(char *args) {
 	return 0;
 }
 
+static int cmd_trace(char *args) {
+	char *arg = strtok(NULL, " ");
+	if(arg == NULL) {
+		printf("Usage: trace start [file] [r] [m] | trace stop\n");
+	}
+	else if(strcmp(arg, "stop") == 0) {
+		trace_stop();
+	}
+	else if(strcmp(arg, "start") == 0) {
+		char *filename = "trace.bin";
+		uint32_t opt = 0;
+		while((arg = strtok(NULL, " ")) != NULL) {
+			if(strcmp(arg, "r") == 0) { opt |= TRACE_OPT_REGS; }
+			else if(strcmp(arg, "m") == 0) { opt |= TRACE_OPT_MEM; }
+			else { filename = arg; }
+		}
+		if(!trace_start(filename, opt)) {
+			printf("Can not open '%s'\n", filename);
+		}
+	}
+	else {
+		printf("Unknown trace command '%s'\n", arg);
+	}
+	return 0;
+}
+
+static int cmd_replay(char *args) {
+	char *arg = strtok(NULL, " ");
+	char *filename = strtok(NULL, " ");
+	if(arg != NULL && strcmp(arg, "stop") == 0) {
+		replay_stop();
+	}
+	else if(arg != NULL && filename != NULL &&
+			(strcmp(arg, "record") == 0 || strcmp(arg, "play") == 0)) {
+		int mode = (arg[0] == 'r' ? REPLAY_RECORD : REPLAY_PLAY);
+		if(!replay_start(mode, filename)) {
+			printf("Can not %s '%s'\n", arg, filename);
+		}
+	}
+	else {
+		printf("Usage: replay record|play [file] | replay stop\n");
+	}
+	return 0;
+}
+
+bool snapshot_save();
+void snapshot_load();
+
+static int cmd_snapshot(char *args) {
+	char *arg = strtok(NULL, " ");
+	if(arg != NULL && strcmp(arg, "save") == 0) {
+		snapshot_save();
+	}
+	else if(arg != NULL && strcmp(arg, "load") == 0) {
+		snapshot_load();
+	}
+	else {
+		printf("Usage: snapshot save|load\n");
+	}
+	return 0;
+}
+
+static int cmd_rev(char *args) {
+	char *arg = strtok(NULL, " ");
+	if(arg != NULL && strcmp(arg, "on") == 0) {
+		char *interval = strtok(NULL, " ");
+		char *budget = strtok(NULL, " ");
+		rev_start(interval ? strtoull(interval, NULL, 0) : 100000,
+				(size_t)(budget ? atoi(budget) : 64) << 20);
+	}
+	else if(arg != NULL && strcmp(arg, "off") == 0) {
+		rev_stop();
+	}
+	else if(arg == NULL) {
+		rev_info();
+	}
+	else {
+		printf("Usage: rev on [interval] [budget in MB] | rev off | rev\n");
+	}
+	return 0;
+}
+
+static int cmd_rsi(char *args) {
+	uint64_t n = 1;
+	if(args) {
+		sscanf(args, "%llu", (unsigned long long *)&n);
+	}
+	rev_step(n);
+	return 0;
+}
+
+static int cmd_rc(char *args) {
+	rev_continue();
+	return 0;
+}
+
+static int cmd_gdb(char *args) {
+	char *arg = strtok(NULL, " ");
+	gdb_serve(arg ? arg : "1234");
+	return 0;
+}
+
 bool get_fun(uint32_t, char*);
 static int cmd_bt(char *args){
 
     uint32_t tmp = cpu.ebp;
     uint32_t addr = cpu.eip;
+    uint32_t arg;
     char name[32];
     int i = 0, j;
     while(get_fun(addr, name)){
         name[31] = '\0';
         printf("#%02d  %08x in %s(",i++, addr, name);
         for(j = 2; j < 6; ++j){
-            if(tmp + j * 4 > 0 && tmp + j * 4 < 0x8000000)
-                printf(" %d%c", swaddr_read(tmp + j*4, 4), j==5?')':',');
+            if(swaddr_debug_read(tmp + j * 4, 4, R_SS, &arg))
+                printf(" %d%c", arg, j==5?')':',');
         }
         printf("\n");
-        addr = swaddr_read(tmp + 4, 4);
-        tmp = swaddr_read(tmp, 4);
+        if(!swaddr_debug_read(tmp + 4, 4, R_SS, &addr) ||
+                !swaddr_debug_read(tmp, 4, R_SS, &tmp))
+            break;
     }
     return 0;
 }
@@ -155,12 +280,19 @@ static struct {
 	{ "c", "Continue the execution of the program", cmd_c },
 	{ "q", "Exit NEMU", cmd_q },
 	{ "si", "si [num] means excute num steps", cmd_si},
-	{ "info", "info r means print the register file", cmd_info},
+	{ "info", "info r/w/c/s prints the register file, watchpoints, instruction counter or opcode statistics, info s reset clears the statistics", cmd_info},
 	{ "x", "x [num] [pos] prints the num values start from pos in the memory", cmd_x},
 	{ "p", "p [expr] prints the result of the expr", cmd_p},
 	{ "w", "w [expr] creates a watchpoint", cmd_w},
 	{ "d", "d [num] deletes watchpoint NO.[num]", cmd_d},
-    { "bt", "print backtrace of all stack frames.", cmd_bt}
+    { "bt", "print backtrace of all stack frames.", cmd_bt},
+	{ "trace", "trace start [file] [r] [m] records a binary trace (with registers/memory writes), trace stop ends it", cmd_trace},
+	{ "replay", "replay record|play [file] records or replays device inputs, replay stop ends it", cmd_replay},
+	{ "snapshot", "snapshot save saves the whole machine, snapshot load restores the latest snapshot", cmd_snapshot},
+	{ "rev", "rev on [interval] [budget in MB] takes checkpoints for reverse execution, rev off stops it", cmd_rev},
+	{ "rsi", "rsi [num] steps num instructions backward", cmd_rsi},
+	{ "rc", "rc runs backward to the last watchpoint or breakpoint hit", cmd_rc},
+	{ "gdb", "gdb [port|path] waits for GDB on a TCP port (1234 by default) or a Unix socket", cmd_gdb}
 
 	/* TODO: Add more commands */
 
@@ -1,5 +1,6 @@
 #include "monitor/watchpoint.h"
 #include "monitor/expr.h"
+#include "monitor/monitor.h"
 
 #define NR_WP 32
 
@@ -49,12 +50,21 @@ void check_wp(int* nemu_state) {
 		int new_value = expr(iter -> expr_string, &success);
 		if (new_value != iter -> value) {
 			*nemu_state = 0;
-			printf("%8x:\twatchpoint %d hit: the value of %s changed from %d to %d\n", cpu.eip, iter->NO, iter->expr_string, iter->value, new_value);
+			if(!nemu_quiet) printf("%8x:\twatchpoint %d hit: the value of %s changed from %d to %d\n", cpu.eip, iter->NO, iter->expr_string, iter->value, new_value);
 			iter -> value = new_value;
 		}
 	}
 }
 
+/* Re-evaluate the watchpoints after the machine state is changed by the monitor. */
+void update_wp() {
+	WP* iter;
+	for(iter = head; iter; iter = iter -> next) {
+		bool success = true;
+		iter -> value = expr(iter -> expr_string, &success);
+	}
+}
+
 void print_wp() {
 	if (head == NULL) {
 		printf("No watchpoint!\n");
@@ -1,5 +1,11 @@
 #include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include "nemu.h"
+#include "cpu/clock.h"
+#include "device/event.h"
+#include "monitor/opstat.h"
 
 #define ENTRY_START 0x100000
 
@@ -11,6 +17,7 @@ void load_elf_tables(int, char *[]);
 void init_regex();
 void init_wp_list();
 void init_ddr3();
+void load_program();
 
 FILE *log_fp = NULL;
 
@@ -43,21 +50,29 @@ void init_monitor(int argc, char *argv[]) {
 	welcome();
 }
 
+#ifndef DIRECT_BOOT
 #ifdef USE_RAMDISK
+/* Map the file with name `argv[1]' into the ramdisk window. The pages
+ * are private, so the writes to the ramdisk never reach the file. The
+ * window is mapped again at every restart to drop the writes of the
+ * last run.
+ */
 static void init_ramdisk() {
-	int ret;
-	const int ramdisk_max_size = 0xa0000;
-	FILE *fp = fopen(exec_file, "rb");
-	Assert(fp, "Can not open '%s'", exec_file);
+	int fd = open(exec_file, O_RDONLY);
+	Assert(fd >= 0, "Can not open '%s'", exec_file);
 
-	fseek(fp, 0, SEEK_END);
-	size_t file_size = ftell(fp);
-	Assert(file_size < ramdisk_max_size, "file size(%zd) too large", file_size);
+	off_t file_size = lseek(fd, 0, SEEK_END);
+	Assert(file_size <= RAMDISK_MAX_SIZE, "file size(%lld) too large", (long long)file_size);
 
-	fseek(fp, 0, SEEK_SET);
-	ret = fread(hwa_to_va(0), file_size, 1, fp);
-	assert(ret == 1);
-	fclose(fp);
+	ramdisk = mmap(ramdisk, RAMDISK_MAX_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | (ramdisk == NULL ? 0 : MAP_FIXED), -1, 0);
+	Assert(ramdisk != MAP_FAILED, "Can not allocate the ramdisk");
+
+	if(file_size > 0) {
+		void *p = mmap(ramdisk, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+		Assert(p != MAP_FAILED, "Can not map '%s'", exec_file);
+	}
+	close(fd);
 }
 #endif
 
@@ -74,11 +89,16 @@ static void load_entry() {
 	assert(ret == 1);
 	fclose(fp);
 }
+#endif
 
 void restart() {
 	/* Perform some initialization to restart a program */
+#ifdef DIRECT_BOOT
+	/* Load the program itself, and start it without the kernel. */
+	load_program();
+#else
 #ifdef USE_RAMDISK
-	/* Read the file with name `argv[1]' into ramdisk. */
+	/* Map the file with name `argv[1]' into ramdisk. */
 	init_ramdisk();
 #endif
 
@@ -87,9 +107,29 @@ void restart() {
 
 	/* Set the initial instruction pointer. */
 	cpu.eip = ENTRY_START;
+#endif
+	cpu.instr_cnt = 0;
+#ifdef VIRTUAL_CLOCK
+	vclock = 0;
+#else
+	event_idle = 0;
+#endif
+#ifdef OPCODE_STAT
+	opstat_reset();
+#endif
 
 	/* Initialize DRAM. */
 	init_ddr3();
 
     cpu.eflags = 0x00000002;
+	cpu.cr0 = cpu.cr2 = cpu.cr3 = cpu.cr4 = 0;
+	page_flush();
+	cpu.gdtr.limit = cpu.gdtr.base = 0;
+	int i;
+	for(i = R_ES; i <= R_DS; i ++) {
+		load_sreg(i, 0);
+	}
+	cpu.idtr.limit = cpu.idtr.base = 0;
+	cpu.INTR = false;
+	cpu.halted = false;
 }
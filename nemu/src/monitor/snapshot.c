@@ -0,0 +1,93 @@
+#include "nemu.h"
+#include "monitor/trace.h"
+#include "device/replay.h"
+
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/* Whole-machine snapshots by fork().
+ *
+ * ``snapshot save'' forks NEMU. The parent process keeps the machine
+ * as it is at the moment of saving and waits, while the child goes on
+ * running. ``snapshot load'' terminates the child with SNAPSHOT_RESTORE,
+ * and the parent forks again to continue from the saved state. Since
+ * fork() shares the unmodified pages of the DRAM, the devices, and the
+ * MMIO/PIO spaces between the processes, saving and loading are cheap
+ * no matter how large the guest memory is.
+ *
+ * Snapshots are nested: loading always returns to the latest one, and
+ * the latest one is kept, so it can be loaded again and again.
+ */
+
+#define SNAPSHOT_RESTORE 0x5a
+
+static int nr_snapshot = 0;
+
+#ifdef HAS_DEVICE
+void restart_device_timer();
+void serial_flush();
+void restart_serial_writer();
+#endif
+
+bool snapshot_save() {
+	if(trace_on || replay_mode != REPLAY_OFF) {
+		printf("Can not take a snapshot while tracing or recording/replaying\n");
+		return false;
+	}
+
+	bool restored = false;
+	while(1) {
+		/* Do not let both processes output the buffered data. */
+#ifdef HAS_DEVICE
+		serial_flush();
+#endif
+		fflush(stdout);
+		fflush(log_fp);
+
+		pid_t pid = fork();
+		Assert(pid >= 0, "Can not fork");
+		if(pid == 0) {
+			/* the running copy of the machine */
+			nr_snapshot ++;
+#ifdef HAS_DEVICE
+			/* the CPU time of the child starts over */
+			restart_device_timer();
+			restart_serial_writer();
+#endif
+			if(!restored) {
+				printf("Snapshot %d saved at instruction %llu\n",
+						nr_snapshot, (unsigned long long)cpu.instr_cnt);
+			}
+			return true;
+		}
+
+		/* the saved copy of the machine, waiting for the running one */
+		int status;
+		void (*old_handler)(int) = signal(SIGINT, SIG_IGN);
+		while(waitpid(pid, &status, 0) < 0);
+		signal(SIGINT, old_handler);
+
+		if(WIFEXITED(status) && WEXITSTATUS(status) == SNAPSHOT_RESTORE) {
+			printf("Snapshot %d restored at instruction %llu\n",
+					nr_snapshot + 1, (unsigned long long)cpu.instr_cnt);
+			restored = true;
+			continue;
+		}
+
+		/* NEMU has quit, so does the saved copy */
+		exit(WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status));
+	}
+}
+
+void snapshot_load() {
+	if(nr_snapshot == 0) {
+		printf("No snapshot has been saved\n");
+		return;
+	}
+
+	trace_stop();
+	replay_stop();
+	exit(SNAPSHOT_RESTORE);
+}
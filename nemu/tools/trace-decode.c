@@ -0,0 +1,167 @@
+/* Offline decoder of the binary trace recorded by the ``trace'' command.
+ *
+ * Usage: trace-decode [-r lo,hi] [-v] trace.bin
+ *   -r lo,hi   only print instructions whose eip is in [lo, hi] (hex)
+ *   -v         also print changed registers and memory writes
+ */
+
+#include "monitor/trace.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+FILE *log_fp = NULL;
+
+static const char *reg_name[TRACE_NR_REG] = {
+	"eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi", "eflags"
+};
+
+/* Instruction bytes seen so far, in pages of the guest address space. */
+static uint8_t *pages[1 << 20];
+
+static void set_byte(uint32_t addr, uint8_t b) {
+	uint8_t **p = &pages[addr >> 12];
+	if(*p == NULL) {
+		*p = calloc(4096, 1);
+		assert(*p);
+	}
+	(*p)[addr & 0xfff] = b;
+}
+
+static uint8_t get_byte(uint32_t addr) {
+	uint8_t *p = pages[addr >> 12];
+	return p ? p[addr & 0xfff] : 0;
+}
+
+static FILE *fp;
+
+static int read_byte() {
+	int c = getc(fp);
+	if(c == EOF) {
+		fprintf(stderr, "unexpected end of the trace\n");
+		exit(1);
+	}
+	return c;
+}
+
+static uint32_t read_varint() {
+	uint32_t v = 0;
+	int shift = 0, c;
+	do {
+		c = read_byte();
+		v |= (uint32_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while(c & 0x80);
+	return v;
+}
+
+#define NR_PENDING_MEM 64
+
+struct {
+	uint32_t addr, data;
+	int len;
+} pending_mem[NR_PENDING_MEM];
+static int nr_pending_mem;
+
+int main(int argc, char *argv[]) {
+	uint32_t lo = 0, hi = 0xffffffff;
+	bool verbose = false;
+	int c;
+	while((c = getopt(argc, argv, "r:v")) != -1) {
+		switch(c) {
+			case 'r':
+				if(sscanf(optarg, "%x,%x", &lo, &hi) != 2) {
+					fprintf(stderr, "bad address range '%s'\n", optarg);
+					return 1;
+				}
+				break;
+			case 'v': verbose = true; break;
+			default: return 1;
+		}
+	}
+
+	if(optind != argc - 1) {
+		fprintf(stderr, "Usage: %s [-r lo,hi] [-v] trace.bin\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(argv[optind], "rb");
+	if(fp == NULL) {
+		fprintf(stderr, "Can not open '%s'\n", argv[optind]);
+		return 1;
+	}
+
+	TraceHeader h;
+	if(fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, TRACE_MAGIC, sizeof(h.magic)) != 0) {
+		fprintf(stderr, "'%s' is not a NEMU trace\n", argv[optind]);
+		return 1;
+	}
+
+	uint32_t next_eip = h.start_eip;
+	uint32_t mem_addr = 0;
+	uint32_t regs[TRACE_NR_REG];
+	uint64_t nr_instr = 0;
+	memcpy(regs, h.start_regs, sizeof(regs));
+
+	while((c = getc(fp)) != EOF) {
+		if(!(c & TRACE_TAG_INSTR)) {
+			/* memory write of the next instruction */
+			mem_addr += zigzag_decode(read_varint());
+			uint32_t data = read_varint();
+			if(nr_pending_mem < NR_PENDING_MEM) {
+				pending_mem[nr_pending_mem].addr = mem_addr;
+				pending_mem[nr_pending_mem].data = data;
+				pending_mem[nr_pending_mem].len = c & TRACE_TAG_MEM_MASK;
+			}
+			nr_pending_mem ++;
+			continue;
+		}
+
+		int len = c & TRACE_LEN_MASK;
+		uint32_t eip = next_eip + zigzag_decode(read_varint());
+		next_eip = eip + len;
+		nr_instr ++;
+
+		int i;
+		if(c & TRACE_HAS_BYTES) {
+			for(i = 0; i < len; i ++) {
+				set_byte(eip + i, read_byte());
+			}
+		}
+
+		uint32_t mask = 0;
+		if(c & TRACE_HAS_REGS) {
+			mask = read_varint();
+			for(i = 0; i < TRACE_NR_REG; i ++) {
+				if(mask & (1 << i)) { regs[i] = read_varint(); }
+			}
+		}
+
+		if(eip >= lo && eip <= hi) {
+			/* the same layout as print_bin_instr() in NEMU */
+			int l = printf("%8x:   ", eip);
+			for(i = 0; i < len; i ++) {
+				l += printf("%02x ", get_byte(eip + i));
+			}
+			printf("%*.s\n", 50 - l, "");
+
+			if(verbose) {
+				for(i = 0; i < TRACE_NR_REG; i ++) {
+					if(mask & (1 << i)) { printf("\t%%%s = 0x%08x\n", reg_name[i], regs[i]); }
+				}
+				for(i = 0; i < nr_pending_mem && i < NR_PENDING_MEM; i ++) {
+					printf("\t[0x%08x] <- 0x%0*x\n", pending_mem[i].addr,
+							pending_mem[i].len * 2, pending_mem[i].data);
+				}
+				if(nr_pending_mem > NR_PENDING_MEM) {
+					printf("\t... %d memory writes in total\n", nr_pending_mem);
+				}
+			}
+		}
+		nr_pending_mem = 0;
+	}
+
+	fclose(fp);
+	fprintf(stderr, "%llu instructions decoded\n", (unsigned long long)nr_instr);
+	return 0;
+}
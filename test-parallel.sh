@@ -0,0 +1,87 @@
+#!/bin/bash
+
+# Run the testcases concurrently, one NEMU process per testcase.
+# The following environment variables can be set:
+#   JOBS     the number of NEMU processes at the same time (default: nproc)
+#   TIMEOUT  the time limit of each testcase in seconds (default: 60)
+#   LIMIT    the limit of guest instructions of each testcase (default: 2000000000)
+#   FORMAT   json or csv (default: json)
+#   OUTPUT   the file to write the result into (default: stdout)
+
+JOBS=${JOBS:-`nproc`}
+TIMEOUT=${TIMEOUT:-60}
+LIMIT=${LIMIT:-2000000000}
+FORMAT=${FORMAT:-json}
+OUTPUT=${OUTPUT:-/dev/stdout}
+
+nemu=`realpath obj/nemu/nemu`
+entry=`realpath entry`
+result_dir=`mktemp -d`
+
+# Each NEMU process runs in its own directory, since it
+# opens ``entry'' and writes ``log.txt'' there.
+run_one() {
+	file=`realpath $1`
+	name=`basename $1`
+	dir=`mktemp -d`
+	ln -s $entry $dir/entry
+
+	start=`date +%s.%N`
+	(cd $dir && printf "si $LIMIT\ninfo c\nq\n" | timeout $TIMEOUT $nemu $file &> output.txt)
+	ret=$?
+	end=`date +%s.%N`
+
+	instr=`sed -n 's/^instructions: \([0-9]*\)$/\1/p' $dir/output.txt | tail -n 1`
+	instr=${instr:-0}
+	if grep -q 'nemu: HIT GOOD TRAP' $dir/output.txt; then
+		result=PASS
+	elif [ $ret -eq 124 ]; then
+		result=TIMEOUT
+	elif [ $instr -ge $LIMIT ]; then
+		result=LIMIT
+	else
+		result=FAIL
+	fi
+
+	if [ $result != PASS ]; then
+		cp $dir/output.txt $name-log.txt
+		if (test -e $dir/log.txt) then
+			echo -e "\n\n===== the original log.txt =====\n" >> $name-log.txt
+			cat $dir/log.txt >> $name-log.txt
+		fi
+	fi
+	rm -rf $dir
+
+	echo $name $result $start $end $instr | awk '{
+		wall = $4 - $3;
+		printf "%s %s %.3f %s %.2f\n", $1, $2, wall, $5, (wall > 0 ? $5 / wall / 1e6 : 0);
+	}' > $result_dir/$name
+}
+
+export -f run_one
+export nemu entry result_dir TIMEOUT LIMIT
+
+printf "%s\n" $@ | xargs -P $JOBS -I{} bash -c 'run_one {}'
+
+cat $result_dir/* | sort | awk -v format=$FORMAT '
+	BEGIN {
+		if(format == "csv") { print "name,result,wall_seconds,instructions,mips"; }
+		else { print "["; }
+	}
+	{
+		if(format == "csv") { printf "%s,%s,%s,%s,%s\n", $1, $2, $3, $4, $5; }
+		else {
+			printf "%s  {\"name\": \"%s\", \"result\": \"%s\", \"wall_seconds\": %s, \"instructions\": %s, \"mips\": %s}",
+				(NR > 1 ? ",\n" : ""), $1, $2, $3, $4, $5;
+		}
+	}
+	END {
+		if(format != "csv") { print "\n]"; }
+	}' > $OUTPUT
+
+pass=`grep -c ' PASS ' $result_dir/* /dev/null | awk -F: '{ n += $2 } END { print n }'`
+total=`ls $result_dir | wc -l`
+rm -rf $result_dir
+
+echo -e "$pass/$total passed" >&2
+[ $pass -eq $total ]
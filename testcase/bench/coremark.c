@@ -0,0 +1,240 @@
+#include "trap.h"
+
+/* A CoreMark-style mix of small kernels: linked list processing,
+ * matrix arithmetic, a state machine scanning numbers in a string,
+ * and CRC-16. Every kernel checks its own result.
+ */
+
+#ifndef ITERATIONS
+#define ITERATIONS 16
+#endif
+
+#define LIST_SIZE 256
+#define MAT_SIZE 16
+#define STR_SIZE 1024
+
+static unsigned seed = 1;
+static unsigned rand() {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+/* CRC-16/CCITT, computed bit by bit and by a table */
+
+unsigned short crc_table[256];
+
+unsigned short crc_bit(unsigned short crc, unsigned char c) {
+	int i;
+	crc ^= c << 8;
+	for(i = 0; i < 8; i ++) {
+		crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+unsigned short crc_fast(unsigned short crc, unsigned char c) {
+	return (crc << 8) ^ crc_table[(crc >> 8) ^ c];
+}
+
+/* linked list */
+
+typedef struct Node {
+	struct Node *next;
+	int key, value;
+} Node;
+
+Node nodes[LIST_SIZE];
+
+Node *list_reverse(Node *p) {
+	Node *q = 0;
+	while(p) {
+		Node *next = p->next;
+		p->next = q;
+		q = p;
+		p = next;
+	}
+	return q;
+}
+
+Node *list_find(Node *p, int key) {
+	while(p && p->key != key) { p = p->next; }
+	return p;
+}
+
+/* merge sort on a list by key */
+Node *list_sort(Node *p) {
+	int width, nmerges;
+	if(!p) { return p; }
+	for(width = 1; ; width <<= 1) {
+		Node *head = 0, *tail = 0, *a = p;
+		nmerges = 0;
+		while(a) {
+			Node *b = a;
+			int la = 0, lb = width;
+			nmerges ++;
+			while(la < width && b) { la ++; b = b->next; }
+			while(la > 0 || (lb > 0 && b)) {
+				Node *e;
+				if(la == 0) { e = b; b = b->next; lb --; }
+				else if(lb == 0 || !b || a->key <= b->key) { e = a; a = a->next; la --; }
+				else { e = b; b = b->next; lb --; }
+				if(tail) { tail->next = e; } else { head = e; }
+				tail = e;
+			}
+			a = b;
+		}
+		tail->next = 0;
+		p = head;
+		if(nmerges <= 1) { return p; }
+	}
+}
+
+unsigned short bench_list(unsigned short crc) {
+	int i;
+	for(i = 0; i < LIST_SIZE; i ++) {
+		nodes[i].key = rand() & 0x3ff;
+		nodes[i].value = i;
+		nodes[i].next = (i + 1 < LIST_SIZE ? &nodes[i + 1] : 0);
+	}
+
+	Node *head = list_reverse(&nodes[0]);
+	nemu_assert(head == &nodes[LIST_SIZE - 1]);
+	for(i = 0; i < LIST_SIZE; i += 16) {
+		Node *n = list_find(head, nodes[i].key);
+		nemu_assert(n && n->key == nodes[i].key);
+	}
+
+	head = list_sort(head);
+	int count = 0;
+	Node *p;
+	for(p = head; p; p = p->next, count ++) {
+		if(p->next) { nemu_assert(p->key <= p->next->key); }
+		crc = crc_fast(crc, p->key);
+	}
+	nemu_assert(count == LIST_SIZE);
+	return crc;
+}
+
+/* matrix: C = A * B + A, then check the sum of C against the row and column sums */
+
+int ma[MAT_SIZE][MAT_SIZE], mb[MAT_SIZE][MAT_SIZE], mc[MAT_SIZE][MAT_SIZE];
+
+unsigned short bench_matrix(unsigned short crc) {
+	int i, j, k;
+	for(i = 0; i < MAT_SIZE; i ++) {
+		for(j = 0; j < MAT_SIZE; j ++) {
+			ma[i][j] = (rand() & 0xff) - 0x80;
+			mb[i][j] = (rand() & 0xff) - 0x80;
+		}
+	}
+
+	int sum = 0;
+	for(i = 0; i < MAT_SIZE; i ++) {
+		for(j = 0; j < MAT_SIZE; j ++) {
+			int s = ma[i][j];
+			for(k = 0; k < MAT_SIZE; k ++) {
+				s += ma[i][k] * mb[k][j];
+			}
+			mc[i][j] = s;
+			sum += s;
+			crc = crc_fast(crc, s);
+		}
+	}
+
+	/* sum(A * B) = sum_k (column sum k of A) * (row sum k of B) */
+	int expect = 0;
+	for(k = 0; k < MAT_SIZE; k ++) {
+		int col = 0, row = 0;
+		for(i = 0; i < MAT_SIZE; i ++) {
+			col += ma[i][k];
+			row += mb[k][i];
+			expect += ma[k][i];
+		}
+		expect += col * row;
+	}
+	nemu_assert(sum == expect);
+	return crc;
+}
+
+/* state machine: count integers, decimals and invalid tokens in a string */
+
+enum { S_START, S_INT, S_DEC, S_INVALID };
+
+char str[STR_SIZE];
+
+unsigned short bench_state(unsigned short crc) {
+	int expect[4] = {0}, count[4] = {0};
+	int len = 0, i;
+	while(len < STR_SIZE - 16) {
+		int type = rand() % 3 + S_INT;
+		int n = rand() % 6 + 1;
+		for(i = 0; i < n; i ++) { str[len ++] = '0' + rand() % 10; }
+		if(type == S_DEC) {
+			str[len ++] = '.';
+			str[len ++] = '0' + rand() % 10;
+		}
+		else if(type == S_INVALID) {
+			str[len ++] = 'x';
+		}
+		str[len ++] = ',';
+		expect[type] ++;
+	}
+	str[len] = '\0';
+
+	int state = S_START;
+	for(i = 0; str[i]; i ++) {
+		char c = str[i];
+		crc = crc_fast(crc, c);
+		if(c == ',') {
+			count[state] ++;
+			state = S_START;
+			continue;
+		}
+		switch(state) {
+			case S_START:
+			case S_INT:
+				if(c >= '0' && c <= '9') { state = S_INT; }
+				else if(c == '.') { state = S_DEC; }
+				else { state = S_INVALID; }
+				break;
+			case S_DEC:
+				if(c < '0' || c > '9') { state = S_INVALID; }
+				break;
+		}
+	}
+
+	for(i = S_INT; i <= S_INVALID; i ++) {
+		nemu_assert(count[i] == expect[i]);
+	}
+	return crc;
+}
+
+int main() {
+	int i, j;
+	for(i = 0; i < 256; i ++) {
+		unsigned short c = i << 8;
+		for(j = 0; j < 8; j ++) {
+			c = (c & 0x8000) ? (c << 1) ^ 0x1021 : c << 1;
+		}
+		crc_table[i] = c;
+	}
+
+	unsigned short crc = 0xffff;
+	for(i = 0; i < ITERATIONS; i ++) {
+		crc = bench_list(crc);
+		crc = bench_matrix(crc);
+		crc = bench_state(crc);
+	}
+
+	/* check the table-driven CRC against the bitwise one */
+	unsigned short c1 = 0xffff, c2 = 0xffff;
+	for(i = 0; i < STR_SIZE && str[i]; i ++) {
+		c1 = crc_bit(c1, str[i]);
+		c2 = crc_fast(c2, str[i]);
+	}
+	nemu_assert(c1 == c2);
+	nemu_assert(crc != 0xffff);
+
+	HIT_GOOD_TRAP;
+	return 0;
+}
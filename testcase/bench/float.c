@@ -0,0 +1,53 @@
+#include "trap.h"
+#include "FLOAT.h"
+
+/* Fixed-point math with FLOAT: pi by Simpson's rule on 4 / (1 + x^2),
+ * and square roots by Newton's method.
+ *
+ * Float literals are avoided, since they are compiled into x87
+ * instructions.
+ */
+
+#ifndef N
+#define N 4096
+#endif
+
+#define PI 205887	/* pi * 65536 */
+
+FLOAT f(FLOAT x) {
+	return F_div_F(int2F(4), int2F(1) + F_mul_F(x, x));
+}
+
+FLOAT simpson(int n) {
+	FLOAT h = F_div_int(int2F(1), n);
+	/* the sum overflows FLOAT when n is large */
+	long long s = f(0) + f(int2F(1));
+	int k;
+	for(k = 1; k < n; k ++) {
+		s += F_mul_int(f(F_mul_int(h, k)), (k & 1) ? 4 : 2);
+	}
+	return F_div_int((FLOAT)((s * h) >> 16), 3);
+}
+
+FLOAT newton_sqrt(FLOAT x) {
+	FLOAT t = x, dt;
+	do {
+		dt = F_div_int(F_div_F(x, t) - t, 2);
+		t += dt;
+	} while(Fabs(dt) > 1);
+	return t;
+}
+
+int main() {
+	nemu_assert(Fabs(simpson(N) - PI) < 64);
+
+	int k;
+	for(k = 1; k < N / 16; k ++) {
+		/* sqrt(k * k / 16) */
+		FLOAT r = newton_sqrt((k * k) << 12);
+		nemu_assert(Fabs(F_mul_int(r, 4) - int2F(k)) < 64);
+	}
+
+	HIT_GOOD_TRAP;
+	return 0;
+}
@@ -0,0 +1,118 @@
+#include "trap.h"
+#include <string.h>
+
+/* Compress text-like data with a greedy LZ77 coder, then decompress
+ * it REPEAT times and compare with the original.
+ *
+ * The YJ_1 decoder of nemu-pal has no matching encoder to produce its
+ * input, so a self-contained LZ77 format is used here:
+ *   0lllllll: a literal run of l + 1 bytes follows
+ *   1lllllll oooooooo oooooooo: copy l + 3 bytes from o + 1 bytes back
+ */
+
+#ifndef N
+#define N (1 << 16)
+#endif
+
+#ifndef REPEAT
+#define REPEAT 4
+#endif
+
+#define HASH_SIZE 4096
+#define MAX_MATCH (127 + 3)
+#define MAX_OFFSET 65536
+
+unsigned char src[N], packed[N + N / 128 + 16], dst[N];
+int hash[HASH_SIZE];
+
+static const char *words[] = {
+	"the ", "emulator ", "executes ", "instructions ", "of ", "guest ",
+	"program ", "and ", "memory ", "page ", "cache ", "register ", "\n",
+};
+
+static unsigned seed = 1;
+static unsigned rand() {
+	seed = seed * 1103515245 + 12345;
+	return seed >> 16;
+}
+
+static int flush_literals(unsigned char *out, const unsigned char *lit, int n) {
+	int len = 0;
+	while(n > 0) {
+		int l = (n > 128 ? 128 : n);
+		out[len ++] = l - 1;
+		memcpy(out + len, lit, l);
+		len += l;
+		lit += l;
+		n -= l;
+	}
+	return len;
+}
+
+int compress(const unsigned char *in, int n, unsigned char *out) {
+	int i = 0, lit = 0, len = 0;
+	memset(hash, 0xff, sizeof(hash));
+	while(i + 3 <= n) {
+		unsigned h = ((in[i] << 8) ^ (in[i + 1] << 4) ^ in[i + 2]) & (HASH_SIZE - 1);
+		int cand = hash[h], m = 0;
+		hash[h] = i;
+		if(cand >= 0 && i - cand <= MAX_OFFSET) {
+			while(m < MAX_MATCH && i + m < n && in[cand + m] == in[i + m]) { m ++; }
+		}
+
+		if(m >= 3) {
+			len += flush_literals(out + len, in + lit, i - lit);
+			int off = i - cand - 1;
+			out[len ++] = 0x80 | (m - 3);
+			out[len ++] = off & 0xff;
+			out[len ++] = off >> 8;
+			i += m;
+			lit = i;
+		}
+		else {
+			i ++;
+		}
+	}
+	len += flush_literals(out + len, in + lit, n - lit);
+	return len;
+}
+
+int decompress(const unsigned char *in, int n, unsigned char *out) {
+	const unsigned char *end = in + n;
+	unsigned char *p = out;
+	while(in < end) {
+		int c = *in ++;
+		if(c & 0x80) {
+			int l = (c & 0x7f) + 3;
+			const unsigned char *from = p - (in[0] | (in[1] << 8)) - 1;
+			in += 2;
+			while(l --) { *p ++ = *from ++; }
+		}
+		else {
+			memcpy(p, in, c + 1);
+			p += c + 1;
+			in += c + 1;
+		}
+	}
+	return p - out;
+}
+
+int main() {
+	int i = 0;
+	while(i < N) {
+		const char *w = words[rand() % (sizeof(words) / sizeof(words[0]))];
+		while(*w && i < N) { src[i ++] = *w ++; }
+	}
+
+	int packed_len = compress(src, N, packed);
+	nemu_assert(packed_len < N / 2);
+
+	for(i = 0; i < REPEAT; i ++) {
+		memset(dst, 0, N);
+		nemu_assert(decompress(packed, packed_len, dst) == N);
+		nemu_assert(memcmp(src, dst, N) == 0);
+	}
+
+	HIT_GOOD_TRAP;
+	return 0;
+}
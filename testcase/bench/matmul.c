@@ -0,0 +1,55 @@
+#include "trap.h"
+
+/* Multiply two N x N matrices, then check C x = A (B x) for a random x. */
+
+#ifndef N
+#define N 64
+#endif
+
+int a[N][N], b[N][N], c[N][N];
+int x[N], bx[N], abx[N], cx[N];
+
+static unsigned seed = 1;
+static int rand() {
+	seed = seed * 1103515245 + 12345;
+	return (seed >> 16) & 0x7fff;
+}
+
+int main() {
+	int i, j, k;
+	for(i = 0; i < N; i ++) {
+		x[i] = rand() - 0x4000;
+		for(j = 0; j < N; j ++) {
+			a[i][j] = rand() - 0x4000;
+			b[i][j] = rand() - 0x4000;
+		}
+	}
+
+	for(i = 0; i < N; i ++) {
+		for(j = 0; j < N; j ++) {
+			int sum = 0;
+			for(k = 0; k < N; k ++) {
+				sum += a[i][k] * b[k][j];
+			}
+			c[i][j] = sum;
+		}
+	}
+
+	for(i = 0; i < N; i ++) {
+		bx[i] = cx[i] = 0;
+		for(j = 0; j < N; j ++) {
+			bx[i] += b[i][j] * x[j];
+			cx[i] += c[i][j] * x[j];
+		}
+	}
+	for(i = 0; i < N; i ++) {
+		abx[i] = 0;
+		for(j = 0; j < N; j ++) {
+			abx[i] += a[i][j] * bx[j];
+		}
+		nemu_assert(abx[i] == cx[i]);
+	}
+
+	HIT_GOOD_TRAP;
+	return 0;
+}
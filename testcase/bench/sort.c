@@ -0,0 +1,58 @@
+#include "trap.h"
+
+/* Merge sort N random integers, then check the order and the checksums. */
+
+#ifndef N
+#define N (1 << 14)
+#endif
+
+int a[N], tmp[N];
+
+static unsigned seed = 1;
+static unsigned rand() {
+	seed = seed * 1103515245 + 12345;
+	return seed ^ (seed >> 15);
+}
+
+void merge_sort(int *a, int n) {
+	int width, i;
+	for(width = 1; width < n; width <<= 1) {
+		for(i = 0; i < n; i += 2 * width) {
+			int l = i, m = i + width, r = i + 2 * width, k = i;
+			int j = m;
+			if(m > n) { m = n; }
+			if(r > n) { r = n; }
+			j = m;
+			while(l < m && j < r) {
+				tmp[k ++] = (a[l] <= a[j] ? a[l ++] : a[j ++]);
+			}
+			while(l < m) { tmp[k ++] = a[l ++]; }
+			while(j < r) { tmp[k ++] = a[j ++]; }
+		}
+		for(i = 0; i < n; i ++) {
+			a[i] = tmp[i];
+		}
+	}
+}
+
+int main() {
+	unsigned sum = 0, xor = 0;
+	int i;
+	for(i = 0; i < N; i ++) {
+		a[i] = rand();
+		sum += a[i];
+		xor ^= a[i];
+	}
+
+	merge_sort(a, N);
+
+	for(i = 0; i < N; i ++) {
+		if(i > 0) { nemu_assert(a[i - 1] <= a[i]); }
+		sum -= a[i];
+		xor ^= a[i];
+	}
+	nemu_assert(sum == 0 && xor == 0);
+
+	HIT_GOOD_TRAP;
+	return 0;
+}
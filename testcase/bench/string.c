@@ -0,0 +1,44 @@
+#include "trap.h"
+#include <string.h>
+
+/* memcpy, memset, strlen, strcpy and strcmp on buffers of all
+ * alignments and many lengths. */
+
+#ifndef N
+#define N 4096
+#endif
+
+#ifndef REPEAT
+#define REPEAT 8
+#endif
+
+char src[N + 8], dst[N + 8], str[N + 8];
+
+int main() {
+	int r, i, len, align;
+	for(i = 0; i < N + 8; i ++) {
+		src[i] = 'a' + i % 26;
+	}
+
+	for(r = 0; r < REPEAT; r ++) {
+		for(align = 0; align < 4; align ++) {
+			for(len = 1; len <= N; len = len * 3 / 2 + 1) {
+				memset(dst, 0, sizeof(dst));
+				memcpy(dst + align, src + r % 4, len);
+				nemu_assert(dst[align] == src[r % 4]);
+				nemu_assert(dst[align + len - 1] == src[r % 4 + len - 1]);
+				nemu_assert(dst[align + len] == 0);
+				nemu_assert(memcmp(dst + align, src + r % 4, len) == 0);
+
+				strcpy(str + align, dst + align);
+				nemu_assert(strlen(str + align) == len);
+				nemu_assert(strcmp(str + align, dst + align) == 0);
+				str[align + len - 1] ++;
+				nemu_assert(strcmp(str + align, dst + align) > 0);
+			}
+		}
+	}
+
+	HIT_GOOD_TRAP;
+	return 0;
+}
@@ -0,0 +1,51 @@
+#include "trap.h"
+
+int add(int a, int b) { return a + b; }
+int sub(int a, int b) { return a - b; }
+int mul(int a, int b) { return a * b; }
+
+int (*table[])(int, int) = {add, sub, mul};
+
+struct {
+	int pad;
+	int (*f)(int, int);
+} ops = {0, sub};
+
+int ans[] = {9, 5, 14};
+
+/* The length of an indirect call depends on its operand, so the calls
+ * through memory are written in assembly: ``call *table(,%ebx,4)'' is
+ * 7 bytes long, and ``call *4(%ebx)'' is 3 bytes long.
+ */
+int call_indexed(int i) {
+	int ret;
+	asm volatile (	"pushl $2;"
+					"pushl $7;"
+					"call *table(,%1,4);"
+					"addl $8, %%esp"
+					: "=a"(ret) : "b"(i) : "ecx", "edx", "memory");
+	return ret;
+}
+
+int call_member() {
+	int ret;
+	asm volatile (	"pushl $2;"
+					"pushl $7;"
+					"call *4(%1);"
+					"addl $8, %%esp"
+					: "=a"(ret) : "b"(&ops) : "ecx", "edx", "memory");
+	return ret;
+}
+
+int main() {
+	int i;
+	for(i = 0; i < 3; i ++) {
+		nemu_assert(call_indexed(i) == ans[i]);
+		nemu_assert(table[i](7, 2) == ans[i]);
+	}
+
+	nemu_assert(call_member() == 5);
+
+	HIT_GOOD_TRAP;
+	return 0;
+}